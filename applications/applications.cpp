@@ -19,137 +19,419 @@
 #include "applications.h"
 
 #include <QDebug>
+#include <QFuture>
 #include <QIcon>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrent>
 
+#include <algorithm>
+#include <vector>
+
+#include <KConfig>
+#include <KConfigGroup>
 #include <KService>
-#include <KServiceGroup>
-#include <KServiceTypeTrader>
+#include <KSharedConfig>
+#include <KSycoca>
 
 #include "tools/runnerhelpers.h"
 
 static const QString s_groupSearchKeyword("_groupRelPath:");
-
-ApplicationsRunner::ApplicationsRunner(QObject *parent)
-    : Sprinter::Runner(parent)
+static const int s_maxTemplatesCost = 8 * 1024 * 1024;
+static const int s_warmupCount = 24;
+// the image size warmed up for before any query said which one is used
+static const int s_defaultWarmupImageSize = 32;
+// candidate lists shorter than this are not worth splitting across threads
+static const int s_minParallelCandidates = 512;
+static const int s_maxMatchThreads = 4;
+// how many candidates the matching thread scores between checks for a stale query
+static const int s_validityCheckInterval = 64;
+
+uint qHash(const MatchTemplateKey &key)
 {
-    setMinQueryLength(1);
+    return qHash(key.storageId) ^ uint((key.imageSize.width() << 16) | (key.imageSize.height() & 0xffff));
 }
 
-ApplicationsRunner::~ApplicationsRunner()
+static int precisionRank(Sprinter::QuerySession::MatchPrecision precision)
 {
+    switch (precision) {
+    case Sprinter::QuerySession::ExactMatch:
+        return 3;
+    case Sprinter::QuerySession::CloseMatch:
+        return 2;
+    case Sprinter::QuerySession::FuzzyMatch:
+        return 1;
+    default:
+        return 0;
+    }
 }
 
-void ApplicationsRunner::generateTopLevelGroups(Sprinter::MatchData &matchData,
-                                                const Sprinter::QueryContext &context)
+// the order all matches are ranked in: by precision, then by how much the
+// user launches them, then by the phase the trader queries used to find them
+// in, and finally in index order
+static bool betterThan(const ApplicationsSessionData::Candidate &a,
+                       const ApplicationsSessionData::Candidate &b)
 {
-    KServiceGroup::Ptr rootGroup = KServiceGroup::root();
-    if (!rootGroup) {
-        return;
+    const int aRank = precisionRank(a.precision);
+    const int bRank = precisionRank(b.precision);
+    if (aRank != bRank) {
+        return aRank > bRank;
     }
 
-    uint skipCount = 0;
+    if (a.boost != b.boost) {
+        return a.boost > b.boost;
+    }
 
-    foreach (KServiceGroup::Ptr group, rootGroup->groupEntries()) {
-        //FIXME: without re-fetching the group, the if() statement below
-        // crashes on kservicegroup.cpp:371:
-        // return group->d_func()->m_serviceList;
-        // d_func() is 0x45454545, rather than an actual d_ptr.
-        group = KServiceGroup::group(group->relPath());
-        if (group->groupEntries().isEmpty() && group->serviceEntries().isEmpty()) {
-            continue;
-        }
+    if (a.phase != b.phase) {
+        return a.phase < b.phase;
+    }
 
-        if (skipCount < matchData.sessionData()->resultsOffset()) {
-            ++skipCount;
-            continue;
+    return a.entry < b.entry;
+}
+
+/**
+ * Keeps the best candidates added to it, up to a limit, and only the best
+ * one for each exec line. The candidates live in a min-heap with the worst
+ * of them on top, so each addition costs O(log limit).
+ */
+class TopCandidates
+{
+public:
+    TopCandidates(const ApplicationsIndex &index, int limit)
+        : m_index(index),
+          m_limit(limit)
+    {
+        m_heap.reserve(limit);
+    }
+
+    void add(const ApplicationsSessionData::Candidate &candidate)
+    {
+        if (candidate.phase == ApplicationsSessionData::NoPhase || m_limit < 1) {
+            return;
         }
 
-        if (matchData.matchCount() >= matchData.sessionData()->resultsPageSize()) {
+        if (isFull() && !betterThan(candidate, worst())) {
             return;
         }
 
-        Sprinter::QueryMatch match;
+        const int exec = m_index.execId(candidate.entry);
+        QHash<int, ApplicationsSessionData::Candidate>::iterator it = m_kept.find(exec);
+        if (it != m_kept.end()) {
+            if (!betterThan(candidate, it.value())) {
+                return;
+            }
 
-        match.setTitle(group->caption());
-        match.setText(group->comment());
-        match.setData(s_groupSearchKeyword + group->relPath());
-        match.setType(Sprinter::QuerySession::ApplicationGroupType);
-        match.setPrecision(Sprinter::QuerySession::AskMeAgainMatch);
-        match.setSource(Sprinter::QuerySession::FromFilesystem);
+            // superseded candidates are dropped once they reach the top of the heap
+            m_superseded.insert(it.value().entry);
+            it.value() = candidate;
+        } else {
+            if (isFull()) {
+                m_kept.remove(m_index.execId(worst().entry));
+                std::pop_heap(m_heap.begin(), m_heap.end(), betterThan);
+                m_heap.pop_back();
+            }
 
-        if (!group->icon().isEmpty()) {
-            match.setImage(generateImage(QIcon::fromTheme(group->icon()), context));
+            m_kept.insert(exec, candidate);
         }
 
-        matchData << match;
+        m_heap.push_back(candidate);
+        std::push_heap(m_heap.begin(), m_heap.end(), betterThan);
+    }
+
+    bool isFull() const
+    {
+        return m_kept.count() >= m_limit;
+    }
+
+    /**
+     * @return true if no candidate of @p precision or below would be kept anymore
+     */
+    bool beats(Sprinter::QuerySession::MatchPrecision precision)
+    {
+        return isFull() && precisionRank(worst().precision) > precisionRank(precision);
     }
+
+    QVector<ApplicationsSessionData::Candidate> results() const
+    {
+        QVector<ApplicationsSessionData::Candidate> results;
+        results.reserve(m_kept.count());
+        foreach (const ApplicationsSessionData::Candidate &candidate, m_kept) {
+            results << candidate;
+        }
+
+        std::sort(results.begin(), results.end(), betterThan);
+        return results;
+    }
+
+private:
+    const ApplicationsSessionData::Candidate &worst()
+    {
+        while (m_superseded.contains(m_heap.front().entry)) {
+            m_superseded.remove(m_heap.front().entry);
+            std::pop_heap(m_heap.begin(), m_heap.end(), betterThan);
+            m_heap.pop_back();
+        }
+
+        return m_heap.front();
+    }
+
+    const ApplicationsIndex &m_index;
+    const int m_limit;
+    std::vector<ApplicationsSessionData::Candidate> m_heap;
+    QHash<int, ApplicationsSessionData::Candidate> m_kept;
+    QSet<int> m_superseded;
+};
+
+/**
+ * Sets up the matches, images and all, that the runner expects to be asked
+ * for soon, on a low priority thread so the match threads don't have to
+ */
+class MatchWarmer : public QRunnable
+{
+public:
+    MatchWarmer(ApplicationsRunner *runner)
+        : m_runner(runner)
+    {
+    }
+
+    void run()
+    {
+        QThread *thread = QThread::currentThread();
+        const QThread::Priority priority = thread->priority();
+        thread->setPriority(QThread::LowestPriority);
+        m_runner->warmup();
+        thread->setPriority(priority == QThread::InheritPriority ? QThread::NormalPriority : priority);
+    }
+
+private:
+    ApplicationsRunner *m_runner;
+};
+
+ApplicationsSessionData::ApplicationsSessionData(Sprinter::Runner *runner)
+    : Sprinter::RunnerSessionData(runner),
+      resultsComplete(false)
+{
 }
 
-void ApplicationsRunner::showEntriesInGroup(const QString &relPath,
-                                            Sprinter::MatchData &matchData,
-                                            const Sprinter::QueryContext &context)
+ApplicationsRunner::ApplicationsRunner(QObject *parent)
+    : Sprinter::Runner(parent),
+      m_index(ApplicationsIndex::load()),
+      m_templates(s_maxTemplatesCost),
+      m_warmupRunning(0),
+      m_warmupRequested(0),
+      m_stopWarmup(0)
 {
-    KServiceGroup::Ptr parentGroup = KServiceGroup::group(relPath);
-    if (!parentGroup) {
-        return;
+    // the index saved by a previous run is mapped straight in; it is only
+    // rebuilt, on first use, when sycoca changed since it was saved
+    m_warmupPool.setMaxThreadCount(1);
+    m_matchPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), s_maxMatchThreads));
+    setMinQueryLength(1);
+    connect(KSycoca::self(), SIGNAL(databaseChanged(QStringList)),
+            this, SLOT(sycocaChanged()));
+
+    // the first session should not start cold either: until a query tells
+    // which image size is wanted, warm up for the one used last time
+    const int size = KConfigGroup(KSharedConfig::openConfig("sprinterrc"), "Applications")
+                         .readEntry("WarmupImageSize", s_defaultWarmupImageSize);
+    m_warmupImageSize = QSize(size, size);
+    startWarmup();
+}
+
+ApplicationsRunner::~ApplicationsRunner()
+{
+    m_stopWarmup.store(1);
+    m_warmupPool.waitForDone();
+    m_matchPool.waitForDone();
+}
+
+Sprinter::RunnerSessionData *ApplicationsRunner::createSessionData()
+{
+    // a new session is about to start typing; get the matches most likely to
+    // be asked for ready with the image size the previous session used
+    startWarmup();
+    return new ApplicationsSessionData(this);
+}
+
+void ApplicationsRunner::noteMatched(const QString &storageId, const Sprinter::QueryContext &context)
+{
+    QMutexLocker lock(&m_warmupLock);
+    m_recentlyMatched.removeOne(storageId);
+    m_recentlyMatched.prepend(storageId);
+    while (m_recentlyMatched.count() > s_warmupCount) {
+        m_recentlyMatched.removeLast();
     }
 
-    uint skipCount = 0;
-    foreach (KServiceGroup::Ptr group, parentGroup->groupEntries()) {
-        //FIXME: without re-fetching the group, the if() statement below
-        // crashes on kservicegroup.cpp:371:
-        // return group->d_func()->m_serviceList;
-        // d_func() is 0x45454545, rather than an actual d_ptr.
-        group = KServiceGroup::group(group->relPath());
-        if (group->groupEntries().isEmpty() && group->serviceEntries().isEmpty()) {
-            continue;
+    const bool newSize = m_warmupImageSize != context.imageSize();
+    m_warmupContext = context;
+    m_warmupImageSize = context.imageSize();
+    lock.unlock();
+
+    if (newSize) {
+        startWarmup();
+
+        // a config object of our own, as this runs on a match thread
+        if (context.imageSize().width() == context.imageSize().height()) {
+            KConfig config("sprinterrc");
+            KConfigGroup(&config, "Applications").writeEntry("WarmupImageSize", context.imageSize().width());
         }
+    }
+}
 
-        if (skipCount < matchData.sessionData()->resultsOffset()) {
-            ++skipCount;
-            continue;
+void ApplicationsRunner::startWarmup()
+{
+    // one warm up at a time is plenty; one asked for while another is
+    // running is done right after it, as the image size may have changed
+    m_warmupRequested.store(1);
+    if (m_warmupRunning.testAndSetOrdered(0, 1)) {
+        m_warmupPool.start(new MatchWarmer(this));
+    }
+}
+
+void ApplicationsRunner::warmup()
+{
+    do {
+        while (m_warmupRequested.fetchAndStoreOrdered(0)) {
+            warmupMatches();
         }
+        m_warmupRunning.store(0);
+        // a request coming in right before the flag was cleared started nothing
+    } while (m_warmupRequested.load() && m_warmupRunning.testAndSetOrdered(0, 1));
+}
 
-        if (matchData.matchCount() >= matchData.sessionData()->resultsPageSize()) {
-            matchData.sessionData()->setCanFetchMoreMatches(true, context);
-            return;
+void ApplicationsRunner::warmupMatches()
+{
+    QStringList storageIds = m_launchHistory.mostLaunched(s_warmupCount);
+    Sprinter::QueryContext context;
+    QSize imageSize;
+    {
+        QMutexLocker lock(&m_warmupLock);
+        foreach (const QString &storageId, m_recentlyMatched) {
+            if (!storageIds.contains(storageId)) {
+                storageIds << storageId;
+            }
         }
+        context = m_warmupContext;
+        imageSize = m_warmupImageSize;
+    }
 
-        Sprinter::QueryMatch match;
+    // before the first query there is no context to render images for
+    const bool haveContext = context.imageSize() == imageSize;
 
-        match.setTitle(group->caption());
-        match.setText(group->comment());
-        match.setData(s_groupSearchKeyword + group->relPath());
-        match.setType(Sprinter::QuerySession::ApplicationGroupType);
-        match.setPrecision(Sprinter::QuerySession::AskMeAgainMatch);
-        match.setSource(Sprinter::QuerySession::FromFilesystem);
+    QSharedPointer<const ApplicationsIndex> index = searchIndex();
+    foreach (const QString &storageId, storageIds) {
+        if (m_stopWarmup.load()) {
+            return;
+        }
 
-        if (!group->icon().isEmpty()) {
-            match.setImage(generateImage(QIcon::fromTheme(group->icon()), context));
+        const int i = index->indexOf(storageId);
+        if (i >= 0) {
+            createMatch(index->entry(i), imageSize, haveContext ? &context : 0);
         }
+    }
+}
 
-        matchData << match;
+void ApplicationsRunner::sycocaChanged()
+{
+    // the index and menu are rebuilt on the next query that needs them
+    QMutexLocker lock(&m_indexLock);
+    m_index.clear();
+    m_menu.clear();
+    lock.unlock();
+
+    QMutexLocker templatesLock(&m_templatesLock);
+    m_templates.clear();
+}
+
+QSharedPointer<const ApplicationsIndex> ApplicationsRunner::searchIndex()
+{
+    QMutexLocker lock(&m_indexLock);
+    if (!m_index) {
+        m_index = ApplicationsIndex::build();
+        m_index->save();
     }
 
-    KService::List services = parentGroup->serviceEntries();
-    foreach (const KService::Ptr &service, services) {
-        if (skipCount < matchData.sessionData()->resultsOffset()) {
-            ++skipCount;
-            continue;
-        }
+    return m_index;
+}
 
-        if (matchData.matchCount() >= matchData.sessionData()->resultsPageSize()) {
-            matchData.sessionData()->setCanFetchMoreMatches(true, context);
-            return;
+QSharedPointer<const ApplicationsMenu> ApplicationsRunner::menu()
+{
+    QMutexLocker lock(&m_indexLock);
+    if (!m_menu) {
+        m_menu = QSharedPointer<const ApplicationsMenu>(new ApplicationsMenu);
+    }
+
+    return m_menu;
+}
+
+void ApplicationsRunner::generateTopLevelGroups(Sprinter::MatchData &matchData,
+                                                const Sprinter::QueryContext &context)
+{
+    QSharedPointer<const ApplicationsMenu> snapshot = menu();
+    const ApplicationsMenu::Group *rootGroup = snapshot->root();
+    if (!rootGroup) {
+        return;
+    }
+
+    const int offset = matchData.sessionData()->resultsOffset();
+    const int end = qMin(rootGroup->groups.count(),
+                         offset + int(matchData.sessionData()->resultsPageSize()));
+    for (int i = offset; i < end; ++i) {
+        addGroupMatch(*rootGroup->groups[i], matchData, context);
+    }
+}
+
+void ApplicationsRunner::showEntriesInGroup(const QString &relPath,
+                                            Sprinter::MatchData &matchData,
+                                            const Sprinter::QueryContext &context)
+{
+    QSharedPointer<const ApplicationsMenu> snapshot = menu();
+    const ApplicationsMenu::Group *parentGroup = snapshot->group(relPath);
+    if (!parentGroup) {
+        return;
+    }
+
+    // sub groups are listed first, followed by the services
+    const int groupCount = parentGroup->groups.count();
+    const int count = groupCount + parentGroup->services.count();
+    const int offset = matchData.sessionData()->resultsOffset();
+    const int end = qMin(count, offset + int(matchData.sessionData()->resultsPageSize()));
+    for (int i = offset; i < end; ++i) {
+        if (i < groupCount) {
+            addGroupMatch(*parentGroup->groups[i], matchData, context);
+        } else {
+            Sprinter::QueryMatch match = createMatch(parentGroup->services[i - groupCount], context);
+            match.setPrecision(Sprinter::QuerySession::ExactMatch);
+            matchData << match;
         }
+    }
 
-        Sprinter::QueryMatch match;
-        match.setPrecision(Sprinter::QuerySession::ExactMatch);
-        setupMatch(service, match, context);
-        matchData << match;
+    if (end < count) {
+        matchData.sessionData()->setCanFetchMoreMatches(true, context);
     }
 }
 
+void ApplicationsRunner::addGroupMatch(const ApplicationsMenu::Group &group,
+                                       Sprinter::MatchData &matchData,
+                                       const Sprinter::QueryContext &context)
+{
+    Sprinter::QueryMatch match;
+
+    match.setTitle(group.caption);
+    match.setText(group.comment);
+    match.setData(s_groupSearchKeyword + group.relPath);
+    match.setType(Sprinter::QuerySession::ApplicationGroupType);
+    match.setPrecision(Sprinter::QuerySession::AskMeAgainMatch);
+    match.setSource(Sprinter::QuerySession::FromFilesystem);
+
+    if (!group.icon.isEmpty()) {
+        match.setImage(generateImage(QIcon::fromTheme(group.icon), context));
+    }
+
+    matchData << match;
+}
+
 void ApplicationsRunner::match(Sprinter::MatchData &matchData)
 {
     Sprinter::QueryContext context = matchData.queryContext();
@@ -166,161 +448,312 @@ void ApplicationsRunner::match(Sprinter::MatchData &matchData)
         return;
     }
 
-    QSet<QString> seen;
-    QString query;
-    uint skipCount = 0;
+    ApplicationsSessionData *sessionData = qobject_cast<ApplicationsSessionData *>(matchData.sessionData());
+    if (!sessionData) {
+        return;
+    }
 
-    // Query syntax doc:
-    // http://techbase.kde.org/Development/Tutorials/Services/Traders#The_KTrader_Query_Language
-    if (term.length() > 1) {
-        // Search for applications which are executable and case-insensitively match the search term
+    QSharedPointer<const ApplicationsIndex> index = searchIndex();
+    const QString foldedTerm = ApplicationsIndex::fold(term);
+
+    const int offset = matchData.sessionData()->resultsOffset();
+    const int wanted = offset + int(matchData.sessionData()->resultsPageSize());
+
+    QVector<ApplicationsSessionData::Candidate> results;
+    QVector<ApplicationsSessionData::Candidate> previous;
+    bool complete = false;
+    bool cached = false;
+    bool refine = false;
+    {
+        QMutexLocker lock(&sessionData->lock);
+        if (sessionData->index == index) {
+            if (sessionData->resultsTerm == foldedTerm &&
+                (sessionData->resultsComplete || sessionData->results.count() >= wanted)) {
+                // fetching more matches for the same query: the results are already ranked
+                results = sessionData->results;
+                complete = sessionData->resultsComplete;
+                cached = true;
+            } else if (sessionData->term == foldedTerm) {
+                // every candidate for this query was scored, but only the top
+                // of them was ranked; rank the rest now
+                results = rankCandidates(*index, sessionData->candidates);
+                complete = true;
+                cached = true;
+                sessionData->resultsTerm = foldedTerm;
+                sessionData->results = results;
+                sessionData->resultsComplete = true;
+            } else if (!sessionData->term.isEmpty() && foldedTerm.startsWith(sessionData->term)) {
+                previous = sessionData->candidates;
+                refine = true;
+            }
+        }
+    }
+
+    if (!cached) {
+        // a copy taken once, so scoring never waits on the history's lock
+        const LaunchHistory::Boosts boosts = m_launchHistory.boosts();
+        TopCandidates top(*index, wanted);
+        QSet<int> scored;
+        auto consider = [&](int i) {
+            if (!scored.contains(i)) {
+                scored.insert(i);
+                top.add(scoreCandidate(*index, i, term.length(), foldedTerm, boosts));
+            }
+        };
+
+        // Sources are searched starting with the one that can return the best
+        // matches. Exact matches all come from the names, and close matches
+        // are always prefix matches, so once the top matches beat what a source
+        // can possibly return, that source and the ones after it are skipped.
+        foreach (int i, index->exactNameMatches(foldedTerm)) {
+            consider(i);
+        }
+
+        if (!top.beats(Sprinter::QuerySession::CloseMatch)) {
+            foreach (int i, index->prefixMatches(foldedTerm)) {
+                consider(i);
+            }
+        }
 
-        query = QString("exist Exec and ('%1' =~ Name)").arg(term);
-        KService::List services = KServiceTypeTrader::self()->query("Application", query);
+        if (!matchData.isValid()) {
+            return;
+        }
 
-        if (!services.isEmpty()) {
-            //qDebug() << service->name() << "is an exact match!" << service->storageId() << service->exec();
-            foreach (const KService::Ptr &service, services) {
-                if (skipCount < matchData.sessionData()->resultsOffset()) {
-                    ++skipCount;
-                    continue;
+        if (!top.beats(Sprinter::QuerySession::FuzzyMatch)) {
+            QVector<int> entries;
+            if (refine) {
+                // anything matching the longer term also matched the previous one,
+                // so only the previous candidates need to be looked at again
+                entries.reserve(previous.count());
+                foreach (const ApplicationsSessionData::Candidate &candidate, previous) {
+                    if (index->matchingFields(candidate.entry, foldedTerm)) {
+                        entries << candidate.entry;
+                    }
                 }
+            } else {
+                // every entry with a field containing the term; they come back in
+                // index order, which puts applications before control modules
+                entries = index->candidates(foldedTerm);
+            }
 
-                if (matchData.matchCount() >= matchData.sessionData()->resultsPageSize()) {
-                    matchData.sessionData()->setCanFetchMoreMatches(true, context);
-                    return;
+            //qDebug() << "got " << entries.count() << " candidates for " << term << refine;
+            // scoring is where short terms spend their time, so long candidate
+            // lists are cut into chunks that are scored concurrently; the first
+            // chunk is scored on this thread while the pool does the others
+            // The pool threads only get values of their own: the session's
+            // match data is checked here, and a stale query cancels them
+            // through a flag they share.
+            const int chunkCount = entries.count() < s_minParallelCandidates ? 1 : m_matchPool.maxThreadCount();
+            const int chunkSize = (entries.count() + chunkCount - 1) / chunkCount;
+            const int termLength = term.length();
+            QSharedPointer<QAtomicInt> cancelled(new QAtomicInt(0));
+            QVector<QFuture<QVector<ApplicationsSessionData::Candidate> > > chunks;
+            for (int begin = chunkSize; begin < entries.count(); begin += chunkSize) {
+                const int end = qMin(begin + chunkSize, entries.count());
+                chunks << QtConcurrent::run(&m_matchPool, [index, entries, begin, end, termLength, foldedTerm, boosts, cancelled]() {
+                    return scoreCandidates(*index, entries, begin, end, termLength, foldedTerm, boosts, *cancelled);
+                });
+            }
+
+            QVector<ApplicationsSessionData::Candidate> candidates;
+            const int firstEnd = qMin(chunkSize, entries.count());
+            for (int begin = 0; begin < firstEnd && !cancelled->load(); begin += s_validityCheckInterval) {
+                if (!matchData.isValid()) {
+                    cancelled->store(1);
+                    break;
                 }
 
-                if (!service->noDisplay() && service->property("NotShowIn", QVariant::String) != "KDE") {
-                    Sprinter::QueryMatch match;
-                    setupMatch(service, match, context);
-                    match.setPrecision(Sprinter::QuerySession::ExactMatch);
-                    matchData << match;
-                    seen.insert(service->storageId());
-                    seen.insert(service->exec());
+                candidates += scoreCandidates(*index, entries, begin, qMin(begin + s_validityCheckInterval, firstEnd),
+                                              termLength, foldedTerm, boosts, *cancelled);
+            }
+
+            for (int i = 0; i < chunks.count(); ++i) {
+                candidates += chunks[i].result();
+            }
+
+            if (!matchData.isValid()) {
+                return;
+            }
+
+            // the chunks are joined in order, so the candidates stay in index order
+            foreach (const ApplicationsSessionData::Candidate &candidate, candidates) {
+                if (!scored.contains(candidate.entry)) {
+                    top.add(candidate);
                 }
             }
+
+            complete = !top.isFull();
+
+            QMutexLocker lock(&sessionData->lock);
+            sessionData->index = index;
+            sessionData->term = foldedTerm;
+            sessionData->candidates = candidates;
         }
+
+        // when the last source was skipped, the candidates of the previous query
+        // are left in place: they still cover every query extending this one
+        results = top.results();
+
+        QMutexLocker lock(&sessionData->lock);
+        sessionData->index = index;
+        sessionData->resultsTerm = foldedTerm;
+        sessionData->results = results;
+        sessionData->resultsComplete = complete;
     }
 
     if (!matchData.isValid()) {
         return;
     }
 
-    // If the term length is < 3, no real point searching the Keywords and GenericName
-    if (term.length() < 3) {
-        query = QString("exist Exec and ( (exist Name and '%1' ~~ Name) or ('%1' ~~ Exec) )").arg(term);
-    } else {
-        // Search for applications which are executable and the term case-insensitive matches any of
-        // * a substring of one of the keywords
-        // * a substring of the GenericName field
-        // * a substring of the Name field
-        // Note that before asking for the content of e.g. Keywords and GenericName we need to ask if
-        // they exist to prevent a tree evaluation error if they are not defined.
-        query = QString("exist Exec and ( (exist Keywords and '%1' ~subin Keywords) or (exist GenericName and '%1' ~~ GenericName) or (exist Name and '%1' ~~ Name) or ('%1' ~~ Exec) )").arg(term);
-    }
-
-    KService::List services = KServiceTypeTrader::self()->query("Application", query);
-    services += KServiceTypeTrader::self()->query("KCModule", query);
-
-    //qDebug() << "got " << services.count() << " services from " << query;
-    foreach (const KService::Ptr &service, services) {
-        if (skipCount < matchData.sessionData()->resultsOffset()) {
-            ++skipCount;
-            continue;
-        }
+    // only the requested page is turned into matches, and so only its
+    // icons are ever rendered
+    const int end = qMin(results.count(), wanted);
+    for (int i = offset; i < end; ++i) {
+        Sprinter::QueryMatch match = createMatch(index->entry(results[i].entry), context);
+        match.setPrecision(results[i].precision);
+        matchData << match;
+    }
 
-        if (matchData.matchCount() >= matchData.sessionData()->resultsPageSize()) {
-            matchData.sessionData()->setCanFetchMoreMatches(true, context);
-            return;
-        }
+    if (end < results.count() || !complete) {
+        matchData.sessionData()->setCanFetchMoreMatches(true, context);
+    }
 
-        if (!matchData.isValid()) {
-            return;
-        }
+    if (offset == 0 && !results.isEmpty()) {
+        noteMatched(index->entry(results.first().entry).storageId, context);
+    }
+}
 
-        if (service->noDisplay()) {
-            continue;
+QVector<ApplicationsSessionData::Candidate> ApplicationsRunner::rankCandidates(const ApplicationsIndex &index,
+                                                                               const QVector<ApplicationsSessionData::Candidate> &candidates)
+{
+    QVector<ApplicationsSessionData::Candidate> ranked;
+    ranked.reserve(candidates.count());
+    foreach (const ApplicationsSessionData::Candidate &candidate, candidates) {
+        if (candidate.phase != ApplicationsSessionData::NoPhase) {
+            ranked << candidate;
         }
+    }
 
-        const QString id = service->storageId();
-        const QString name = service->desktopEntryName();
-        const QString exec = service->exec();
+    std::sort(ranked.begin(), ranked.end(), betterThan);
 
-        if (seen.contains(id) || seen.contains(exec)) {
-            //qDebug() << "already seen" << id << exec;
+    QVector<ApplicationsSessionData::Candidate> results;
+    QSet<int> seen;
+    foreach (const ApplicationsSessionData::Candidate &candidate, ranked) {
+        // entries sharing a storage id also share their exec line
+        const int exec = index.execId(candidate.entry);
+        if (seen.contains(exec)) {
+            //qDebug() << "already seen" << index.storageIdRef(candidate.entry);
             continue;
         }
 
-        //qDebug() << "haven't seen" << id << "so processing now";
-        seen.insert(id);
         seen.insert(exec);
+        results << candidate;
+    }
+
+    return results;
+}
+
+QVector<ApplicationsSessionData::Candidate> ApplicationsRunner::scoreCandidates(const ApplicationsIndex &index,
+                                                                                const QVector<int> &entries,
+                                                                                int begin, int end, int termLength,
+                                                                                const QString &foldedTerm,
+                                                                                const LaunchHistory::Boosts &boosts,
+                                                                                const QAtomicInt &cancelled)
+{
+    QVector<ApplicationsSessionData::Candidate> candidates;
+    candidates.reserve(end - begin);
+    for (int i = begin; i < end; ++i) {
+        if (cancelled.load()) {
+            break;
+        }
+
+        candidates << scoreCandidate(index, entries[i], termLength, foldedTerm, boosts);
+    }
+
+    return candidates;
+}
+
+ApplicationsSessionData::Candidate ApplicationsRunner::scoreCandidate(const ApplicationsIndex &index,
+                                                                      int i, int termLength,
+                                                                      const QString &foldedTerm,
+                                                                      const LaunchHistory::Boosts &boosts)
+{
+    ApplicationsSessionData::Candidate candidate = matchCandidate(index, i, termLength, foldedTerm);
+    if (candidate.phase != ApplicationsSessionData::NoPhase) {
+        candidate.boost = boosts.value(index.storageIdRef(i));
+    }
 
-        Sprinter::QueryMatch match;
-        setupMatch(service, match, context);
+    return candidate;
+}
+
+ApplicationsSessionData::Candidate ApplicationsRunner::matchCandidate(const ApplicationsIndex &index,
+                                                                      int i, int termLength,
+                                                                      const QString &foldedTerm)
+{
+    ApplicationsSessionData::Candidate candidate;
+    candidate.entry = i;
+    candidate.precision = Sprinter::QuerySession::UnrelatedMatch;
+    candidate.phase = ApplicationsSessionData::NoPhase;
+    candidate.boost = 0;
+
+    const ApplicationsIndex::Fields fields = index.matchingFields(i, foldedTerm);
+
+    // applications whose name is, case-insensitively, the search term
+    if (termLength > 1 && (fields & ApplicationsIndex::NameField) &&
+        !index.isKCModule(i) && !index.notShowInKDE(i) && index.nameEquals(i, foldedTerm)) {
+        //qDebug() << index.storageIdRef(i) << "is an exact match!";
+        candidate.precision = Sprinter::QuerySession::ExactMatch;
+        candidate.phase = ApplicationsSessionData::NamePhase;
+        return candidate;
+    }
+
+    // If the term length is < 3, no real point searching the Keywords and GenericName
+    const ApplicationsIndex::Fields textFields = termLength < 3 ?
+        ApplicationsIndex::NameField | ApplicationsIndex::ExecField :
+        ApplicationsIndex::NameField | ApplicationsIndex::GenericNameField |
+        ApplicationsIndex::KeywordsField | ApplicationsIndex::ExecField;
+
+    if (fields & textFields) {
         Sprinter::QuerySession::MatchPrecision precision = Sprinter::QuerySession::FuzzyMatch;
+        bool matched = true;
 
         // If the term was < 3 chars and NOT at the beginning of the App's name or Exec, then
         // chances are the user doesn't want that app.
-        if (term.length() < 3) {
-            if (name.startsWith(term) || exec.startsWith(term)) {
+        if (termLength < 3) {
+            if (index.hasPrefix(i, foldedTerm)) {
                 precision = Sprinter::QuerySession::CloseMatch;
             } else {
-                continue;
+                matched = false;
             }
-        } else if (service->name().contains(term, Qt::CaseInsensitive)) {
-            if (service->name().startsWith(term, Qt::CaseInsensitive)) {
+        } else if (fields & ApplicationsIndex::NameField) {
+            if (index.nameStartsWith(i, foldedTerm)) {
                 precision = Sprinter::QuerySession::CloseMatch;
             } else {
                 precision = Sprinter::QuerySession::FuzzyMatch;
             }
-        } else if (service->genericName().contains(term, Qt::CaseInsensitive)) {
-            if (service->genericName().startsWith(term, Qt::CaseInsensitive)) {
+        } else if (fields & ApplicationsIndex::GenericNameField) {
+            if (index.genericNameStartsWith(i, foldedTerm)) {
                 precision = Sprinter::QuerySession::CloseMatch;
             } else {
                 precision = Sprinter::QuerySession::FuzzyMatch;
             }
         }
 
-        //qDebug() << service->name() << "is this precise:" << precision;
-        match.setPrecision(precision);
-        matchData << match;
+        if (matched) {
+            //qDebug() << index.storageIdRef(i) << "is this precise:" << precision;
+            candidate.precision = precision;
+            candidate.phase = ApplicationsSessionData::TextPhase;
+            return candidate;
+        }
     }
 
     //search for applications whose categories contains the query
-    query = QString("exist Exec and (exist Categories and '%1' ~subin Categories)").arg(term);
-    services = KServiceTypeTrader::self()->query("Application", query);
-
-    //qDebug() << service->name() << "is an exact match!" << service->storageId() << service->exec();
-    foreach (const KService::Ptr &service, services) {
-        if (skipCount < matchData.sessionData()->resultsOffset()) {
-            ++skipCount;
-            continue;
-        }
-
-        if (matchData.matchCount() >= matchData.sessionData()->resultsPageSize()) {
-            matchData.sessionData()->setCanFetchMoreMatches(true, context);
-            return;
-        }
-
-        if (!matchData.isValid()) {
-            return;
-        }
-
-        if (!service->noDisplay()) {
-            const QString id = service->storageId();
-            const QString exec = service->exec();
-            if (seen.contains(id) || seen.contains(exec)) {
-                //qDebug() << "already seen" << id << exec;
-                continue;
-            }
-
-            Sprinter::QueryMatch match;
-            setupMatch(service, match, context);
-            match.setPrecision(Sprinter::QuerySession::FuzzyMatch);
-            matchData << match;
-        }
+    if (fields & ApplicationsIndex::CategoriesField) {
+        candidate.precision = Sprinter::QuerySession::FuzzyMatch;
+        candidate.phase = ApplicationsSessionData::CategoryPhase;
     }
+
+    return candidate;
 }
 
 bool ApplicationsRunner::exec(const Sprinter::QueryMatch &match)
@@ -330,27 +763,67 @@ bool ApplicationsRunner::exec(const Sprinter::QueryMatch &match)
         return false;
     }
 
-    return RunnerHelpers::blockingKRun(service->exec());
+    if (!RunnerHelpers::blockingKRun(service->exec())) {
+        return false;
+    }
+
+    m_launchHistory.recordLaunch(service->storageId());
+    return true;
 }
 
-void ApplicationsRunner::setupMatch(const KService::Ptr &service, Sprinter::QueryMatch &match, const Sprinter::QueryContext &context)
+Sprinter::QueryMatch ApplicationsRunner::createMatch(const ApplicationsIndex::Entry &entry,
+                                                    const Sprinter::QueryContext &context)
 {
-    const QString name = service->name();
+    return createMatch(entry, context.imageSize(), &context);
+}
+
+Sprinter::QueryMatch ApplicationsRunner::createMatch(const ApplicationsIndex::Entry &entry,
+                                                    const QSize &imageSize,
+                                                    const Sprinter::QueryContext *context)
+{
+    const MatchTemplateKey key(entry.storageId, imageSize);
+
+    {
+        QMutexLocker lock(&m_templatesLock);
+        Sprinter::QueryMatch *matchTemplate = m_templates.object(key);
+        if (matchTemplate) {
+            return *matchTemplate;
+        }
+    }
+
+    Sprinter::QueryMatch *matchTemplate = new Sprinter::QueryMatch;
+    setupMatch(entry, *matchTemplate, imageSize, context);
+    const Sprinter::QueryMatch match = *matchTemplate;
 
-    match.setTitle(name);
-    match.setUserData(service->entryPath());
-    match.setData(service->storageId());
+    // the cost is the size of the image, which dwarfs the strings
+    QMutexLocker lock(&m_templatesLock);
+    m_templates.insert(key, matchTemplate, qMax(1, match.image().byteCount()));
+    return match;
+}
+
+void ApplicationsRunner::setupMatch(const ApplicationsIndex::Entry &entry, Sprinter::QueryMatch &match,
+                                    const QSize &imageSize, const Sprinter::QueryContext *context)
+{
+    match.setTitle(entry.name);
+    match.setUserData(entry.entryPath);
+    match.setData(entry.storageId);
     match.setType(Sprinter::QuerySession::ExecutableType);
     match.setSource(Sprinter::QuerySession::FromFilesystem);
 
-    if (!service->genericName().isEmpty() && service->genericName() != name) {
-        match.setText(service->genericName());
-    } else if (!service->comment().isEmpty()) {
-        match.setText(service->comment());
+    if (!entry.genericName.isEmpty() && entry.genericName != entry.name) {
+        match.setText(entry.genericName);
+    } else if (!entry.comment.isEmpty()) {
+        match.setText(entry.comment);
     }
 
-    if (!service->icon().isEmpty()) {
-        match.setImage(generateImage(QIcon::fromTheme(service->icon()), context));
+    if (entry.icon.isEmpty()) {
+        return;
+    }
+
+    if (context) {
+        match.setImage(generateImage(QIcon::fromTheme(entry.icon), *context));
+    } else {
+        match.setImage(QIcon::fromTheme(entry.icon).pixmap(imageSize).toImage());
     }
 }
 
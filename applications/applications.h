@@ -20,10 +20,82 @@
 #define SERVICERUNNER_H
 
 
+#include <QAtomicInt>
+#include <QCache>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QSize>
+#include <QStringList>
+#include <QThreadPool>
+
 #include <KService>
 
 #include <Sprinter/Runner>
 
+#include "applicationsindex.h"
+#include "applicationsmenu.h"
+#include "launchhistory.h"
+
+struct MatchTemplateKey
+{
+    MatchTemplateKey(const QString &id, const QSize &size)
+        : storageId(id),
+          imageSize(size)
+    {
+    }
+
+    bool operator==(const MatchTemplateKey &other) const
+    {
+        return imageSize == other.imageSize && storageId == other.storageId;
+    }
+
+    QString storageId;
+    QSize imageSize;
+};
+
+uint qHash(const MatchTemplateKey &key);
+
+class ApplicationsSessionData : public Sprinter::RunnerSessionData
+{
+    Q_OBJECT
+
+public:
+    ApplicationsSessionData(Sprinter::Runner *runner);
+
+    enum MatchPhase {
+        NamePhase = 0,
+        TextPhase,
+        CategoryPhase,
+        NoPhase
+    };
+
+    struct Candidate
+    {
+        int entry;
+        Sprinter::QuerySession::MatchPrecision precision;
+        MatchPhase phase;
+        qreal boost;
+    };
+
+    QMutex lock;
+    QSharedPointer<const ApplicationsIndex> index;
+    /**
+     * candidates holds every index entry with a field containing term, scored
+     * against it; queries extending term only need to look at these.
+     */
+    QString term;
+    QVector<Candidate> candidates;
+
+    /**
+     * The best matches for resultsTerm, ranked and de-duplicated, so further
+     * pages are a slice of it. Unless resultsComplete is set, only the top
+     * matches that were asked for have been ranked.
+     */
+    QString resultsTerm;
+    QVector<Candidate> results;
+    bool resultsComplete;
+};
+
 class ApplicationsRunner : public Sprinter::Runner
 {
     Q_OBJECT
@@ -34,18 +106,88 @@ public:
     ApplicationsRunner(QObject *parent = 0);
     ~ApplicationsRunner();
 
+    Sprinter::RunnerSessionData *createSessionData();
     void match(Sprinter::MatchData &matchData);
     bool exec(const Sprinter::QueryMatch &match);
 
+    /**
+     * Sets up the matches for the most launched and most recently matched
+     * services, so they are cached by the time they are asked for, until no
+     * more warm ups were asked for. Called from MatchWarmer.
+     */
+    void warmup();
+
+private Q_SLOTS:
+    void sycocaChanged();
+
 private:
+    QSharedPointer<const ApplicationsIndex> searchIndex();
+    QSharedPointer<const ApplicationsMenu> menu();
+    void noteMatched(const QString &storageId, const Sprinter::QueryContext &context);
+    void startWarmup();
+    void warmupMatches();
+    static QVector<ApplicationsSessionData::Candidate> scoreCandidates(const ApplicationsIndex &index,
+                                                                       const QVector<int> &entries,
+                                                                       int begin, int end, int termLength,
+                                                                       const QString &foldedTerm,
+                                                                       const LaunchHistory::Boosts &boosts,
+                                                                       const QAtomicInt &cancelled);
+    static ApplicationsSessionData::Candidate scoreCandidate(const ApplicationsIndex &index,
+                                                             int i, int termLength,
+                                                             const QString &foldedTerm,
+                                                             const LaunchHistory::Boosts &boosts);
+    static ApplicationsSessionData::Candidate matchCandidate(const ApplicationsIndex &index,
+                                                             int i, int termLength,
+                                                             const QString &foldedTerm);
+    static QVector<ApplicationsSessionData::Candidate> rankCandidates(const ApplicationsIndex &index,
+                                                                      const QVector<ApplicationsSessionData::Candidate> &candidates);
+
     void generateTopLevelGroups(Sprinter::MatchData &matchData,
                                 const Sprinter::QueryContext &context);
     void showEntriesInGroup(const QString &relPath,
                             Sprinter::MatchData &matchData,
                             const Sprinter::QueryContext &context);
-    void setupMatch(const KService::Ptr &service,
+    void addGroupMatch(const ApplicationsMenu::Group &group,
+                       Sprinter::MatchData &matchData,
+                       const Sprinter::QueryContext &context);
+    Sprinter::QueryMatch createMatch(const ApplicationsIndex::Entry &entry,
+                                     const Sprinter::QueryContext &context);
+    /**
+     * Without a @p context, as when warming up before the first query, the
+     * image is rendered straight from the icon at @p imageSize
+     */
+    Sprinter::QueryMatch createMatch(const ApplicationsIndex::Entry &entry,
+                                     const QSize &imageSize,
+                                     const Sprinter::QueryContext *context);
+    void setupMatch(const ApplicationsIndex::Entry &entry,
                     Sprinter::QueryMatch &action,
-                    const Sprinter::QueryContext &context);
+                    const QSize &imageSize,
+                    const Sprinter::QueryContext *context);
+
+    QMutex m_indexLock;
+    QSharedPointer<const ApplicationsIndex> m_index;
+    QSharedPointer<const ApplicationsMenu> m_menu;
+
+    /**
+     * Fully set up matches, image included, per service and image size;
+     * matches for services that were seen before are copies of these
+     */
+    QMutex m_templatesLock;
+    QCache<MatchTemplateKey, Sprinter::QueryMatch> m_templates;
+
+    QMutex m_warmupLock;
+    QStringList m_recentlyMatched;
+    Sprinter::QueryContext m_warmupContext;
+    QSize m_warmupImageSize;
+    QThreadPool m_warmupPool;
+    QAtomicInt m_warmupRunning;
+    QAtomicInt m_warmupRequested;
+    QAtomicInt m_stopWarmup;
+
+    LaunchHistory m_launchHistory;
+
+    // scores large candidate lists in parallel
+    QThreadPool m_matchPool;
 };
 
 
@@ -0,0 +1,856 @@
+/*
+ *   Copyright (C) 2026 the Sprinter plugins contributors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "applicationsindex.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QPair>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QStringList>
+
+#include <algorithm>
+#include <cstring>
+
+#include <KServiceTypeTrader>
+#include <KSycoca>
+
+static const int s_maxGramLength = 3;
+
+// the index is mapped as is, so it is stored in native byte order; the
+// marker makes an index from a machine with the other byte order unreadable
+static const char s_magic[4] = { 'S', 'A', 'I', 'X' };
+static const quint32 s_version = 2;
+static const quint32 s_byteOrder = 0x01020304;
+
+// tables start on 8 byte boundaries so the gram keys can be read in place
+static const int s_tableAlignment = 8;
+
+enum EntryFlag {
+    KCModuleFlag = 0x01,
+    NotShowInKDEFlag = 0x02
+};
+
+// a table in the index: its offset in bytes from the start of the index and
+// the number of items in it
+struct ApplicationsIndex::Section
+{
+    quint32 offset;
+    quint32 count;
+};
+
+// a string in the pool: its offset and length in UTF-16 code units
+struct ApplicationsIndex::StringRef
+{
+    quint32 offset;
+    quint32 length;
+};
+
+struct ApplicationsIndex::Header
+{
+    char magic[4];
+    quint32 version;
+    quint32 byteOrder;
+    // the size of the whole index, and a checksum of this header computed
+    // with the checksum itself set to 0
+    quint32 size;
+    quint32 checksum;
+    quint32 sycocaTimeStamp;
+    StringRef language;
+    Section entries;
+    Section strings;
+    Section lists;
+    Section grams;
+    Section postings;
+    Section names;
+    Section prefixes;
+    Section storageIds;
+};
+
+struct ApplicationsIndex::EntryRecord
+{
+    StringRef storageId;
+    StringRef entryPath;
+    StringRef desktopEntryName;
+    StringRef name;
+    StringRef genericName;
+    StringRef comment;
+    StringRef icon;
+    StringRef exec;
+    StringRef foldedDesktopEntryName;
+    StringRef foldedName;
+    StringRef foldedGenericName;
+    StringRef foldedExec;
+    // ranges of the folded keywords and categories in the lists table
+    Section keywords;
+    Section categories;
+    quint32 execId;
+    quint32 flags;
+};
+
+// the posting list of a gram: a range of the postings table
+struct ApplicationsIndex::GramRecord
+{
+    quint64 key;
+    quint32 offset;
+    quint32 count;
+};
+
+// an item of a table of (folded) strings sorted by code units, then entry
+struct ApplicationsIndex::SortedRef
+{
+    StringRef string;
+    quint32 entry;
+};
+
+// packs up to three UTF-16 code units, plus the gram length, into one key
+static quint64 gramKey(const QChar *chars, int length)
+{
+    quint64 key = length;
+    for (int i = 0; i < length; ++i) {
+        key = (key << 16) | chars[i].unicode();
+    }
+    return key;
+}
+
+static QVector<int> intersect(const QVector<int> &left, const quint32 *right, int rightCount)
+{
+    QVector<int> result;
+    result.reserve(qMin(left.size(), rightCount));
+
+    QVector<int>::const_iterator l = left.constBegin();
+    const quint32 *r = right;
+    const quint32 *rightEnd = right + rightCount;
+    while (l != left.constEnd() && r != rightEnd) {
+        if (quint32(*l) < *r) {
+            ++l;
+        } else if (*r < quint32(*l)) {
+            ++r;
+        } else {
+            result << *l;
+            ++l;
+            ++r;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Collects the services and writes them out in the flat layout of the index
+ */
+class ApplicationsIndex::Builder
+{
+public:
+    Builder()
+        : m_count(0)
+    {
+    }
+
+    void addService(const KService::Ptr &service, bool isKCModule);
+    QByteArray serialize(quint32 sycocaTimeStamp, const QString &language);
+
+private:
+    typedef QPair<QString, SortedRef> SortedItem;
+
+    StringRef addString(const QString &string);
+    Section addList(const QStringList &strings);
+    void addGrams(const QString &string, int index);
+    void addSorted(QVector<SortedItem> &table, const QString &string, const StringRef &ref, int index);
+    static QVector<SortedRef> sorted(QVector<SortedItem> &table);
+    template<typename T>
+    static Section appendTable(QByteArray &data, const T *items, int count);
+
+    int m_count;
+    QString m_strings;
+    QVector<EntryRecord> m_entries;
+    QVector<StringRef> m_lists;
+    QHash<QString, int> m_execIds;
+    QHash<quint64, QVector<quint32> > m_grams;
+    QVector<SortedItem> m_names;
+    QVector<SortedItem> m_prefixes;
+    QVector<SortedItem> m_storageIds;
+};
+
+void ApplicationsIndex::Builder::addService(const KService::Ptr &service, bool isKCModule)
+{
+    if (!service || service->noDisplay()) {
+        return;
+    }
+
+    const int index = m_count++;
+    const Entry entry = createEntry(service, isKCModule);
+
+    const QString foldedDesktopEntryName = fold(entry.desktopEntryName);
+    const QString foldedName = fold(entry.name);
+    const QString foldedGenericName = fold(entry.genericName);
+    const QString foldedExec = fold(entry.exec);
+
+    QStringList keywords;
+    foreach (const QString &keyword, service->keywords()) {
+        keywords << fold(keyword);
+    }
+
+    QStringList categories;
+    if (!isKCModule) {
+        // categories are only ever searched for applications
+        foreach (const QString &category, service->categories()) {
+            categories << fold(category);
+        }
+    }
+
+    EntryRecord record;
+    record.storageId = addString(entry.storageId);
+    record.entryPath = addString(entry.entryPath);
+    record.desktopEntryName = addString(entry.desktopEntryName);
+    record.name = addString(entry.name);
+    record.genericName = addString(entry.genericName);
+    record.comment = addString(entry.comment);
+    record.icon = addString(entry.icon);
+    record.exec = addString(entry.exec);
+    record.foldedDesktopEntryName = addString(foldedDesktopEntryName);
+    record.foldedName = addString(foldedName);
+    record.foldedGenericName = addString(foldedGenericName);
+    record.foldedExec = addString(foldedExec);
+    record.keywords = addList(keywords);
+    record.categories = addList(categories);
+    record.execId = m_execIds.contains(entry.exec) ? m_execIds.value(entry.exec) : index;
+    record.flags = (entry.isKCModule ? KCModuleFlag : 0) | (entry.notShowInKDE ? NotShowInKDEFlag : 0);
+    m_execIds.insert(entry.exec, record.execId);
+    m_entries << record;
+
+    addSorted(m_storageIds, entry.storageId, record.storageId, index);
+    addSorted(m_names, foldedName, record.foldedName, index);
+    addSorted(m_prefixes, foldedName, record.foldedName, index);
+    addSorted(m_prefixes, foldedGenericName, record.foldedGenericName, index);
+    addSorted(m_prefixes, foldedDesktopEntryName, record.foldedDesktopEntryName, index);
+    addSorted(m_prefixes, foldedExec, record.foldedExec, index);
+
+    addGrams(foldedName, index);
+    addGrams(foldedGenericName, index);
+    addGrams(foldedExec, index);
+    foreach (const QString &keyword, keywords) {
+        addGrams(keyword, index);
+    }
+    foreach (const QString &category, categories) {
+        addGrams(category, index);
+    }
+}
+
+ApplicationsIndex::StringRef ApplicationsIndex::Builder::addString(const QString &string)
+{
+    StringRef ref;
+    ref.offset = m_strings.length();
+    ref.length = string.length();
+    m_strings += string;
+    return ref;
+}
+
+ApplicationsIndex::Section ApplicationsIndex::Builder::addList(const QStringList &strings)
+{
+    Section list;
+    list.offset = m_lists.count();
+    list.count = strings.count();
+    foreach (const QString &string, strings) {
+        m_lists << addString(string);
+    }
+    return list;
+}
+
+void ApplicationsIndex::Builder::addGrams(const QString &string, int index)
+{
+    const QChar *chars = string.constData();
+    const int length = string.length();
+    for (int gramLength = 1; gramLength <= s_maxGramLength; ++gramLength) {
+        for (int i = 0; i + gramLength <= length; ++i) {
+            QVector<quint32> &postings = m_grams[gramKey(chars + i, gramLength)];
+            // entries are added in order, so the posting lists stay sorted
+            // and only the last item needs checking for duplicates
+            if (postings.isEmpty() || postings.last() != quint32(index)) {
+                postings << index;
+            }
+        }
+    }
+}
+
+void ApplicationsIndex::Builder::addSorted(QVector<SortedItem> &table, const QString &string,
+                                           const StringRef &ref, int index)
+{
+    if (!string.isEmpty()) {
+        SortedRef sortedRef;
+        sortedRef.string = ref;
+        sortedRef.entry = index;
+        table << qMakePair(string, sortedRef);
+    }
+}
+
+QVector<ApplicationsIndex::SortedRef> ApplicationsIndex::Builder::sorted(QVector<SortedItem> &table)
+{
+    std::sort(table.begin(), table.end(),
+              [](const SortedItem &a, const SortedItem &b) {
+                  return a.first < b.first || (a.first == b.first && a.second.entry < b.second.entry);
+              });
+
+    QVector<SortedRef> refs;
+    refs.reserve(table.count());
+    foreach (const SortedItem &item, table) {
+        refs << item.second;
+    }
+    return refs;
+}
+
+template<typename T>
+ApplicationsIndex::Section ApplicationsIndex::Builder::appendTable(QByteArray &data, const T *items, int count)
+{
+    const int padding = (s_tableAlignment - data.size() % s_tableAlignment) % s_tableAlignment;
+    data.append(QByteArray(padding, '\0'));
+
+    Section section;
+    section.offset = data.size();
+    section.count = count;
+    data.append(reinterpret_cast<const char *>(items), count * sizeof(T));
+    return section;
+}
+
+QByteArray ApplicationsIndex::Builder::serialize(quint32 sycocaTimeStamp, const QString &language)
+{
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, s_magic, sizeof(s_magic));
+    header.version = s_version;
+    header.byteOrder = s_byteOrder;
+    header.sycocaTimeStamp = sycocaTimeStamp;
+    header.language = addString(language);
+
+    QList<quint64> keys = m_grams.keys();
+    std::sort(keys.begin(), keys.end());
+
+    QVector<GramRecord> grams;
+    QVector<quint32> postings;
+    grams.reserve(keys.count());
+    foreach (quint64 key, keys) {
+        const QVector<quint32> &list = m_grams[key];
+        GramRecord gram;
+        gram.key = key;
+        gram.offset = postings.count();
+        gram.count = list.count();
+        grams << gram;
+        postings += list;
+    }
+
+    const QVector<SortedRef> names = sorted(m_names);
+    const QVector<SortedRef> prefixes = sorted(m_prefixes);
+    const QVector<SortedRef> storageIds = sorted(m_storageIds);
+
+    QByteArray data(sizeof(Header), '\0');
+    header.entries = appendTable(data, m_entries.constData(), m_entries.count());
+    header.strings = appendTable(data, m_strings.constData(), m_strings.length());
+    header.lists = appendTable(data, m_lists.constData(), m_lists.count());
+    header.grams = appendTable(data, grams.constData(), grams.count());
+    header.postings = appendTable(data, postings.constData(), postings.count());
+    header.names = appendTable(data, names.constData(), names.count());
+    header.prefixes = appendTable(data, prefixes.constData(), prefixes.count());
+    header.storageIds = appendTable(data, storageIds.constData(), storageIds.count());
+    header.size = data.size();
+    header.checksum = headerChecksum(header);
+    memcpy(data.data(), &header, sizeof(Header));
+
+    //qDebug() << "indexed" << m_count << "services using" << grams.count() << "grams in" << data.size() << "bytes";
+    return data;
+}
+
+ApplicationsIndex::ApplicationsIndex(const QByteArray &buffer, QFile *file, const uchar *data, qint64 size)
+    : m_buffer(buffer),
+      m_file(file),
+      m_size(size),
+      m_data(data),
+      m_header(0),
+      m_entries(0),
+      m_strings(0),
+      m_lists(0),
+      m_grams(0),
+      m_postings(0),
+      m_names(0),
+      m_prefixes(0),
+      m_storageIds(0)
+{
+}
+
+ApplicationsIndex::~ApplicationsIndex()
+{
+    // also unmaps the index
+    delete m_file;
+}
+
+QSharedPointer<const ApplicationsIndex> ApplicationsIndex::build()
+{
+    // this is the only place sycoca is walked; everything after this is
+    // answered from the index
+    Builder builder;
+    foreach (const KService::Ptr &service, KServiceTypeTrader::self()->query("Application", "exist Exec")) {
+        builder.addService(service, false);
+    }
+
+    foreach (const KService::Ptr &service, KServiceTypeTrader::self()->query("KCModule", "exist Exec")) {
+        builder.addService(service, true);
+    }
+
+    const QByteArray data = builder.serialize(KSycoca::self()->timeStamp(), KSycoca::self()->language());
+    QSharedPointer<ApplicationsIndex> index(
+        new ApplicationsIndex(data, 0, reinterpret_cast<const uchar *>(data.constData()), data.size()));
+    const bool valid = index->setup();
+    Q_ASSERT(valid);
+    Q_UNUSED(valid)
+    return index;
+}
+
+QSharedPointer<const ApplicationsIndex> ApplicationsIndex::load(const QString &path)
+{
+    QFile *file = new QFile(path);
+    const uchar *data = 0;
+    if (file->open(QIODevice::ReadOnly)) {
+        data = file->map(0, file->size());
+    }
+
+    if (!data) {
+        delete file;
+        return QSharedPointer<const ApplicationsIndex>();
+    }
+
+    QSharedPointer<ApplicationsIndex> index(new ApplicationsIndex(QByteArray(), file, data, file->size()));
+    if (!index->setup()) {
+        qDebug() << "ignoring application index with unknown format" << path;
+        return QSharedPointer<const ApplicationsIndex>();
+    }
+
+    if (index->m_header->sycocaTimeStamp != KSycoca::self()->timeStamp() ||
+        index->stringRef(index->m_header->language) != KSycoca::self()->language()) {
+        //qDebug() << "application index is stale" << path;
+        return QSharedPointer<const ApplicationsIndex>();
+    }
+
+    return index;
+}
+
+bool ApplicationsIndex::save(const QString &path) const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(reinterpret_cast<const char *>(m_data), m_size) != m_size) {
+        return false;
+    }
+
+    return file.commit();
+}
+
+QString ApplicationsIndex::cachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+           QStringLiteral("/sprinter/applications.index");
+}
+
+bool ApplicationsIndex::setup()
+{
+    // a saved index may have been truncated or damaged after it was written.
+    // The header and the table bounds are checked here, which catches a
+    // partial write; the offsets within the tables are only checked when
+    // they are used, so loading does not touch the rest of the index.
+    // A bad index is refused and rebuilt just like a stale one.
+    if (m_size < qint64(sizeof(Header))) {
+        return false;
+    }
+
+    m_header = reinterpret_cast<const Header *>(m_data);
+    if (memcmp(m_header->magic, s_magic, sizeof(s_magic)) != 0 ||
+        m_header->version != s_version || m_header->byteOrder != s_byteOrder ||
+        qint64(m_header->size) != m_size || m_header->checksum != headerChecksum(*m_header)) {
+        return false;
+    }
+
+    m_entries = table<EntryRecord>(m_header->entries);
+    m_strings = table<QChar>(m_header->strings);
+    m_lists = table<StringRef>(m_header->lists);
+    m_grams = table<GramRecord>(m_header->grams);
+    m_postings = table<quint32>(m_header->postings);
+    m_names = table<SortedRef>(m_header->names);
+    m_prefixes = table<SortedRef>(m_header->prefixes);
+    m_storageIds = table<SortedRef>(m_header->storageIds);
+
+    return m_entries && m_strings && m_lists && m_grams && m_postings &&
+           m_names && m_prefixes && m_storageIds && fits(m_header->language);
+}
+
+quint32 ApplicationsIndex::headerChecksum(Header header)
+{
+    header.checksum = 0;
+    return qChecksum(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+bool ApplicationsIndex::fits(const StringRef &ref) const
+{
+    return quint64(ref.offset) + ref.length <= m_header->strings.count;
+}
+
+bool ApplicationsIndex::fits(const Section &range, quint32 count) const
+{
+    return quint64(range.offset) + range.count <= count;
+}
+
+bool ApplicationsIndex::isEntry(quint32 index) const
+{
+    return index < m_header->entries.count;
+}
+
+const QChar *ApplicationsIndex::chars(const StringRef &ref, quint32 *length) const
+{
+    // a damaged reference reads as an empty string
+    if (!fits(ref)) {
+        *length = 0;
+        return m_strings;
+    }
+
+    *length = ref.length;
+    return m_strings + ref.offset;
+}
+
+const quint32 *ApplicationsIndex::postings(const GramRecord *gram, quint32 *count) const
+{
+    Section range;
+    range.offset = gram->offset;
+    range.count = gram->count;
+    if (!fits(range, m_header->postings.count)) {
+        *count = 0;
+        return m_postings;
+    }
+
+    *count = gram->count;
+    return m_postings + gram->offset;
+}
+
+template<typename T>
+const T *ApplicationsIndex::table(const Section &section) const
+{
+    if (section.offset % Q_ALIGNOF(T) != 0 || section.offset > m_size ||
+        quint64(section.count) * sizeof(T) > quint64(m_size - section.offset)) {
+        return 0;
+    }
+
+    return reinterpret_cast<const T *>(m_data + section.offset);
+}
+
+ApplicationsIndex::Entry ApplicationsIndex::createEntry(const KService::Ptr &service, bool isKCModule)
+{
+    Entry entry;
+    entry.storageId = service->storageId();
+    entry.entryPath = service->entryPath();
+    entry.desktopEntryName = service->desktopEntryName();
+    entry.name = service->name();
+    entry.genericName = service->genericName();
+    entry.comment = service->comment();
+    entry.icon = service->icon();
+    entry.exec = service->exec();
+    entry.isKCModule = isKCModule;
+    entry.notShowInKDE = service->property("NotShowIn", QVariant::String).toString() == QLatin1String("KDE");
+    return entry;
+}
+
+QString ApplicationsIndex::fold(const QString &string)
+{
+    return string.toCaseFolded();
+}
+
+int ApplicationsIndex::count() const
+{
+    return m_header->entries.count;
+}
+
+ApplicationsIndex::Entry ApplicationsIndex::entry(int index) const
+{
+    const EntryRecord &record = m_entries[index];
+    Entry entry;
+    entry.storageId = string(record.storageId);
+    entry.entryPath = string(record.entryPath);
+    entry.desktopEntryName = string(record.desktopEntryName);
+    entry.name = string(record.name);
+    entry.genericName = string(record.genericName);
+    entry.comment = string(record.comment);
+    entry.icon = string(record.icon);
+    entry.exec = string(record.exec);
+    entry.isKCModule = record.flags & KCModuleFlag;
+    entry.notShowInKDE = record.flags & NotShowInKDEFlag;
+    return entry;
+}
+
+QString ApplicationsIndex::storageIdRef(int index) const
+{
+    return stringRef(m_entries[index].storageId);
+}
+
+int ApplicationsIndex::execId(int index) const
+{
+    const quint32 execId = m_entries[index].execId;
+    return isEntry(execId) ? int(execId) : index;
+}
+
+bool ApplicationsIndex::isKCModule(int index) const
+{
+    return m_entries[index].flags & KCModuleFlag;
+}
+
+bool ApplicationsIndex::notShowInKDE(int index) const
+{
+    return m_entries[index].flags & NotShowInKDEFlag;
+}
+
+int ApplicationsIndex::indexOf(const QString &storageId) const
+{
+    const SortedRef *end = m_storageIds + m_header->storageIds.count;
+    const SortedRef *it = lowerBound(m_storageIds, end, storageId);
+    return it != end && equals(it->string, storageId) && isEntry(it->entry) ? int(it->entry) : -1;
+}
+
+QVector<int> ApplicationsIndex::exactNameMatches(const QString &foldedTerm) const
+{
+    QVector<int> result;
+    const SortedRef *end = m_names + m_header->names.count;
+    for (const SortedRef *it = lowerBound(m_names, end, foldedTerm);
+         it != end && equals(it->string, foldedTerm); ++it) {
+        if (isEntry(it->entry)) {
+            result << it->entry;
+        }
+    }
+
+    return result;
+}
+
+QVector<int> ApplicationsIndex::prefixMatches(const QString &foldedTerm) const
+{
+    QVector<int> result;
+    if (foldedTerm.isEmpty()) {
+        return result;
+    }
+
+    // the strings sharing the prefix are next to each other in the sorted table
+    const SortedRef *end = m_prefixes + m_header->prefixes.count;
+    for (const SortedRef *it = lowerBound(m_prefixes, end, foldedTerm);
+         it != end && startsWith(it->string, foldedTerm); ++it) {
+        if (isEntry(it->entry)) {
+            result << it->entry;
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+QVector<int> ApplicationsIndex::candidates(const QString &foldedTerm) const
+{
+    const int length = foldedTerm.length();
+    if (length == 0) {
+        return QVector<int>();
+    }
+
+    const QChar *chars = foldedTerm.constData();
+    if (length <= s_maxGramLength) {
+        QVector<int> result;
+        const GramRecord *gram = findGram(gramKey(chars, length));
+        if (gram) {
+            quint32 count;
+            const quint32 *list = postings(gram, &count);
+            result.reserve(count);
+            for (quint32 i = 0; i < count; ++i) {
+                if (isEntry(list[i])) {
+                    result << list[i];
+                }
+            }
+        }
+        return result;
+    }
+
+    // start from the rarest trigram to keep the intersections short
+    QVector<const GramRecord *> lists;
+    for (int i = 0; i + s_maxGramLength <= length; ++i) {
+        const GramRecord *gram = findGram(gramKey(chars + i, s_maxGramLength));
+        if (!gram) {
+            return QVector<int>();
+        }
+
+        lists << gram;
+    }
+
+    std::sort(lists.begin(), lists.end(),
+              [](const GramRecord *a, const GramRecord *b) { return a->count < b->count; });
+
+    quint32 count;
+    const quint32 *first = postings(lists.first(), &count);
+    QVector<int> result;
+    result.reserve(count);
+    for (quint32 i = 0; i < count; ++i) {
+        if (isEntry(first[i])) {
+            result << first[i];
+        }
+    }
+
+    for (int i = 1; i < lists.count() && !result.isEmpty(); ++i) {
+        const quint32 *list = postings(lists[i], &count);
+        result = intersect(result, list, count);
+    }
+
+    // the grams may come from different fields or positions, so verify
+    QVector<int> verified;
+    verified.reserve(result.size());
+    foreach (int index, result) {
+        if (matchingFields(index, foldedTerm)) {
+            verified << index;
+        }
+    }
+
+    return verified;
+}
+
+ApplicationsIndex::Fields ApplicationsIndex::matchingFields(int index, const QString &foldedTerm) const
+{
+    const EntryRecord &record = m_entries[index];
+    Fields fields;
+
+    if (contains(record.foldedName, foldedTerm)) {
+        fields |= NameField;
+    }
+
+    if (contains(record.foldedGenericName, foldedTerm)) {
+        fields |= GenericNameField;
+    }
+
+    if (anyContains(record.keywords, foldedTerm)) {
+        fields |= KeywordsField;
+    }
+
+    if (anyContains(record.categories, foldedTerm)) {
+        fields |= CategoriesField;
+    }
+
+    if (contains(record.foldedExec, foldedTerm)) {
+        fields |= ExecField;
+    }
+
+    return fields;
+}
+
+bool ApplicationsIndex::hasPrefix(int index, const QString &foldedTerm) const
+{
+    const EntryRecord &record = m_entries[index];
+    return startsWith(record.foldedDesktopEntryName, foldedTerm) || startsWith(record.foldedExec, foldedTerm);
+}
+
+bool ApplicationsIndex::nameEquals(int index, const QString &foldedTerm) const
+{
+    return equals(m_entries[index].foldedName, foldedTerm);
+}
+
+bool ApplicationsIndex::nameStartsWith(int index, const QString &foldedTerm) const
+{
+    return startsWith(m_entries[index].foldedName, foldedTerm);
+}
+
+bool ApplicationsIndex::genericNameStartsWith(int index, const QString &foldedTerm) const
+{
+    return startsWith(m_entries[index].foldedGenericName, foldedTerm);
+}
+
+QString ApplicationsIndex::string(const StringRef &ref) const
+{
+    quint32 length;
+    const QChar *begin = chars(ref, &length);
+    return QString(begin, length);
+}
+
+QString ApplicationsIndex::stringRef(const StringRef &ref) const
+{
+    quint32 length;
+    const QChar *begin = chars(ref, &length);
+    return QString::fromRawData(begin, length);
+}
+
+// the folded strings are compared code unit by code unit, right where they
+// are stored, so matching never allocates
+bool ApplicationsIndex::contains(const StringRef &ref, const QString &foldedTerm) const
+{
+    if (foldedTerm.isEmpty()) {
+        return true;
+    }
+
+    quint32 length;
+    const QChar *begin = chars(ref, &length);
+    const QChar *end = begin + length;
+    return std::search(begin, end, foldedTerm.constBegin(), foldedTerm.constEnd()) != end;
+}
+
+bool ApplicationsIndex::startsWith(const StringRef &ref, const QString &foldedTerm) const
+{
+    quint32 length;
+    const QChar *begin = chars(ref, &length);
+    return length >= uint(foldedTerm.length()) &&
+           memcmp(begin, foldedTerm.constData(), foldedTerm.length() * sizeof(QChar)) == 0;
+}
+
+bool ApplicationsIndex::equals(const StringRef &ref, const QString &foldedTerm) const
+{
+    return ref.length == uint(foldedTerm.length()) && startsWith(ref, foldedTerm);
+}
+
+bool ApplicationsIndex::anyContains(const Section &list, const QString &foldedTerm) const
+{
+    if (!fits(list, m_header->lists.count)) {
+        return false;
+    }
+
+    for (quint32 i = 0; i < list.count; ++i) {
+        if (contains(m_lists[list.offset + i], foldedTerm)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const ApplicationsIndex::SortedRef *ApplicationsIndex::lowerBound(const SortedRef *begin, const SortedRef *end,
+                                                                  const QString &foldedTerm) const
+{
+    return std::lower_bound(begin, end, foldedTerm,
+                            [this](const SortedRef &item, const QString &term) {
+                                quint32 length;
+                                const QChar *itemChars = chars(item.string, &length);
+                                return std::lexicographical_compare(itemChars, itemChars + length,
+                                                                    term.constBegin(), term.constEnd());
+                            });
+}
+
+const ApplicationsIndex::GramRecord *ApplicationsIndex::findGram(quint64 key) const
+{
+    const GramRecord *end = m_grams + m_header->grams.count;
+    const GramRecord *it = std::lower_bound(m_grams, end, key,
+                                            [](const GramRecord &gram, quint64 key) { return gram.key < key; });
+    return it != end && it->key == key ? it : 0;
+}
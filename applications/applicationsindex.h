@@ -0,0 +1,203 @@
+/*
+ *   Copyright (C) 2026 the Sprinter plugins contributors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef APPLICATIONSINDEX_H
+#define APPLICATIONSINDEX_H
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <KService>
+
+class QFile;
+
+/**
+ * An immutable search index over the applications and control modules known
+ * to ksycoca. It is built once from the service trader and then answers
+ * queries without touching sycoca again.
+ *
+ * All searchable fields are case folded; the index maps every 1, 2 and 3
+ * character gram of those fields to the (sorted) list of entries containing
+ * it. Terms up to three characters are answered with a single lookup, longer
+ * terms by intersecting the posting lists of their trigrams.
+ *
+ * The index lives in a single flat block of memory made of fixed size tables
+ * and a UTF-16 string pool, so the very same bytes can be saved to the user
+ * cache and mapped back in on the next start without any parsing. A saved
+ * index remembers the sycoca time stamp and language it was built from and
+ * is refused once either changes.
+ */
+class ApplicationsIndex
+{
+public:
+    struct Entry
+    {
+        QString storageId;
+        QString entryPath;
+        QString desktopEntryName;
+        QString name;
+        QString genericName;
+        QString comment;
+        QString icon;
+        QString exec;
+        bool isKCModule;
+        bool notShowInKDE;
+    };
+
+    enum Field {
+        NameField = 0x01,
+        GenericNameField = 0x02,
+        KeywordsField = 0x04,
+        CategoriesField = 0x08,
+        ExecField = 0x10
+    };
+    Q_DECLARE_FLAGS(Fields, Field)
+
+    ~ApplicationsIndex();
+
+    /**
+     * Builds a new index by walking the service trader
+     */
+    static QSharedPointer<const ApplicationsIndex> build();
+
+    /**
+     * Maps the index saved at @p path
+     * @return the index, or a null pointer if there is none or it was built
+     * from a different sycoca database
+     */
+    static QSharedPointer<const ApplicationsIndex> load(const QString &path = cachePath());
+
+    /**
+     * Writes the index to @p path so it can be loaded again later
+     */
+    bool save(const QString &path = cachePath()) const;
+
+    static QString cachePath();
+
+    static Entry createEntry(const KService::Ptr &service, bool isKCModule = false);
+    static QString fold(const QString &string);
+
+    int count() const;
+
+    /**
+     * @return a copy of entry @p index, safe to keep beyond the life time of the index
+     */
+    Entry entry(int index) const;
+
+    /**
+     * @return the storage id of entry @p index; the string refers to the
+     * memory of the index and must not outlive it
+     */
+    QString storageIdRef(int index) const;
+
+    /**
+     * @return an id shared by all entries with the same exec line
+     */
+    int execId(int index) const;
+
+    bool isKCModule(int index) const;
+    bool notShowInKDE(int index) const;
+
+    /**
+     * @return the entry for the service with @p storageId, or -1 if it is not indexed
+     */
+    int indexOf(const QString &storageId) const;
+
+    /**
+     * @return the entries whose name equals @p foldedTerm
+     */
+    QVector<int> exactNameMatches(const QString &foldedTerm) const;
+
+    /**
+     * @return the sorted list of entries whose name, generic name, desktop
+     * entry name or exec line start with @p foldedTerm
+     */
+    QVector<int> prefixMatches(const QString &foldedTerm) const;
+
+    /**
+     * @return the sorted list of entries where at least one searchable field
+     * contains @p foldedTerm
+     */
+    QVector<int> candidates(const QString &foldedTerm) const;
+
+    /**
+     * @return the fields of entry @p index that contain @p foldedTerm
+     */
+    Fields matchingFields(int index, const QString &foldedTerm) const;
+
+    /**
+     * @return true if the folded desktop entry name or exec line of the
+     * entry start with @p foldedTerm
+     */
+    bool hasPrefix(int index, const QString &foldedTerm) const;
+
+    bool nameEquals(int index, const QString &foldedTerm) const;
+    bool nameStartsWith(int index, const QString &foldedTerm) const;
+    bool genericNameStartsWith(int index, const QString &foldedTerm) const;
+
+private:
+    struct Header;
+    struct Section;
+    struct StringRef;
+    struct EntryRecord;
+    struct GramRecord;
+    struct SortedRef;
+    class Builder;
+
+    ApplicationsIndex(const QByteArray &buffer, QFile *file, const uchar *data, qint64 size);
+    Q_DISABLE_COPY(ApplicationsIndex)
+
+    bool setup();
+    static quint32 headerChecksum(Header header);
+    bool fits(const StringRef &ref) const;
+    bool fits(const Section &range, quint32 count) const;
+    bool isEntry(quint32 index) const;
+    const QChar *chars(const StringRef &ref, quint32 *length) const;
+    const quint32 *postings(const GramRecord *gram, quint32 *count) const;
+    template<typename T>
+    const T *table(const Section &section) const;
+
+    QString string(const StringRef &ref) const;
+    QString stringRef(const StringRef &ref) const;
+    bool contains(const StringRef &ref, const QString &foldedTerm) const;
+    bool startsWith(const StringRef &ref, const QString &foldedTerm) const;
+    bool equals(const StringRef &ref, const QString &foldedTerm) const;
+    bool anyContains(const Section &list, const QString &foldedTerm) const;
+    const SortedRef *lowerBound(const SortedRef *begin, const SortedRef *end, const QString &foldedTerm) const;
+    const GramRecord *findGram(quint64 key) const;
+
+    QByteArray m_buffer;
+    QFile *m_file;
+    qint64 m_size;
+    const uchar *m_data;
+    const Header *m_header;
+    const EntryRecord *m_entries;
+    const QChar *m_strings;
+    const StringRef *m_lists;
+    const GramRecord *m_grams;
+    const quint32 *m_postings;
+    const SortedRef *m_names;
+    const SortedRef *m_prefixes;
+    const SortedRef *m_storageIds;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(ApplicationsIndex::Fields)
+
+#endif
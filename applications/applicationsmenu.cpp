@@ -0,0 +1,80 @@
+/*
+ *   Copyright (C) 2014 Aaron Seigo <aseigo@kde.org>
+ *   Copyright (C) 2026 the Sprinter plugins contributors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "applicationsmenu.h"
+
+ApplicationsMenu::ApplicationsMenu()
+    : m_root(0)
+{
+    KServiceGroup::Ptr root = KServiceGroup::root();
+    if (root) {
+        m_root = addGroup(root);
+    }
+}
+
+ApplicationsMenu::~ApplicationsMenu()
+{
+    qDeleteAll(m_groups);
+}
+
+const ApplicationsMenu::Group *ApplicationsMenu::root() const
+{
+    return m_root;
+}
+
+const ApplicationsMenu::Group *ApplicationsMenu::group(const QString &relPath) const
+{
+    return m_groupsByPath.value(relPath);
+}
+
+ApplicationsMenu::Group *ApplicationsMenu::addGroup(const KServiceGroup::Ptr &serviceGroup)
+{
+    Group *group = new Group;
+    group->relPath = serviceGroup->relPath();
+    group->caption = serviceGroup->caption();
+    group->comment = serviceGroup->comment();
+    group->icon = serviceGroup->icon();
+    m_groups << group;
+    m_groupsByPath.insert(group->relPath, group);
+
+    foreach (KServiceGroup::Ptr child, serviceGroup->groupEntries()) {
+        //FIXME: without re-fetching the group, the if() statement below
+        // crashes on kservicegroup.cpp:371:
+        // return group->d_func()->m_serviceList;
+        // d_func() is 0x45454545, rather than an actual d_ptr.
+        // This now only happens once per group, when the snapshot is built.
+        child = KServiceGroup::group(child->relPath());
+        if (!child) {
+            continue;
+        }
+
+        Group *childGroup = addGroup(child);
+        if (!childGroup->groups.isEmpty() || !childGroup->services.isEmpty()) {
+            group->groups << childGroup;
+        }
+    }
+
+    foreach (const KService::Ptr &service, serviceGroup->serviceEntries()) {
+        group->services << ApplicationsIndex::createEntry(service);
+    }
+
+    group->groups.squeeze();
+    group->services.squeeze();
+    return group;
+}
@@ -0,0 +1,75 @@
+/*
+ *   Copyright (C) 2014 Aaron Seigo <aseigo@kde.org>
+ *   Copyright (C) 2026 the Sprinter plugins contributors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef APPLICATIONSMENU_H
+#define APPLICATIONSMENU_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include <KServiceGroup>
+
+#include "applicationsindex.h"
+
+/**
+ * An immutable snapshot of the applications menu. Every group is fetched
+ * from ksycoca exactly once when the snapshot is built; browsing it
+ * afterwards is a walk over plain pointers.
+ *
+ * Groups that contain neither services nor non-empty sub groups are left
+ * out of their parent's list of groups, as there is nothing to browse in them.
+ */
+class ApplicationsMenu
+{
+public:
+    struct Group
+    {
+        QString relPath;
+        QString caption;
+        QString comment;
+        QString icon;
+        QVector<const Group *> groups;
+        QVector<ApplicationsIndex::Entry> services;
+    };
+
+    ApplicationsMenu();
+    ~ApplicationsMenu();
+
+    /**
+     * @return the root of the menu, or 0 if there is no menu
+     */
+    const Group *root() const;
+
+    /**
+     * @return the group at @p relPath, or 0 if there is no such group
+     */
+    const Group *group(const QString &relPath) const;
+
+private:
+    Q_DISABLE_COPY(ApplicationsMenu)
+
+    Group *addGroup(const KServiceGroup::Ptr &serviceGroup);
+
+    const Group *m_root;
+    QVector<Group *> m_groups;
+    QHash<QString, const Group *> m_groupsByPath;
+};
+
+#endif
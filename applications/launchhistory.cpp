@@ -0,0 +1,241 @@
+/*
+ *   Copyright (C) 2026 the Sprinter plugins contributors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "launchhistory.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// file header: magic, version
+static const char s_magic[4] = { 'S', 'A', 'L', 'H' };
+static const quint32 s_version = 1;
+static const int s_headerSize = 8;
+
+// record header: count (u32), last used in seconds since the epoch (i64),
+// length of the UTF-8 storage id (u16), followed by the storage id itself
+static const int s_recordHeaderSize = 14;
+
+// launches lose half their weight every 30 days
+static const qreal s_halfLife = 30 * 24 * 60 * 60;
+
+LaunchHistory::LaunchHistory(const QString &path)
+    : m_path(path),
+      m_records(0)
+{
+    load();
+}
+
+QString LaunchHistory::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) +
+           QStringLiteral("/sprinter/applications.launches");
+}
+
+void LaunchHistory::load()
+{
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < s_headerSize) {
+        return;
+    }
+
+    const uchar *data = file.map(0, file.size());
+    if (!data) {
+        return;
+    }
+
+    const uchar *end = data + file.size();
+    if (memcmp(data, s_magic, sizeof(s_magic)) != 0 ||
+        qFromLittleEndian<quint32>(data + sizeof(s_magic)) != s_version) {
+        qDebug() << "replacing launch history with unknown format" << m_path;
+        file.close();
+        // start over with an empty log; appending to this one would lose
+        // every launch from now on as well
+        compact();
+        return;
+    }
+
+    const uchar *record = data + s_headerSize;
+    while (record + s_recordHeaderSize <= end) {
+        const quint32 count = qFromLittleEndian<quint32>(record);
+        const qint64 lastUsed = qFromLittleEndian<qint64>(record + 4);
+        const quint16 length = qFromLittleEndian<quint16>(record + 12);
+        if (record + s_recordHeaderSize + length > end) {
+            break;
+        }
+
+        record += s_recordHeaderSize;
+        const QString storageId = QString::fromUtf8(reinterpret_cast<const char *>(record), length);
+        record += length;
+
+        Stats &stats = m_stats[storageId];
+        stats.count += count;
+        stats.lastUsed = qMax(stats.lastUsed, lastUsed);
+        ++m_records;
+    }
+
+    if (record != end) {
+        // a partially written record at the end of the log; the launches
+        // appended after it would be misread, so drop it
+        file.close();
+        compact();
+    }
+}
+
+void LaunchHistory::recordLaunch(const QString &storageId)
+{
+    if (storageId.isEmpty()) {
+        return;
+    }
+
+    QWriteLocker lock(&m_lock);
+    Stats launch;
+    launch.count = 1;
+    launch.lastUsed = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    Stats &stats = m_stats[storageId];
+    stats.count += launch.count;
+    stats.lastUsed = launch.lastUsed;
+
+    if (append(storageId, launch, false)) {
+        ++m_records;
+    }
+
+    if (m_records > m_stats.count() * 4 + 64) {
+        compact();
+    }
+}
+
+bool LaunchHistory::append(const QString &storageId, const Stats &stats, bool truncate)
+{
+    QFile file(m_path);
+    const bool exists = !truncate && file.exists() && file.size() >= s_headerSize;
+    if (!exists) {
+        QDir().mkpath(QFileInfo(m_path).absolutePath());
+    }
+
+    if (!file.open(exists ? QIODevice::Append : QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QByteArray bytes;
+    if (!exists) {
+        bytes.resize(s_headerSize);
+        memcpy(bytes.data(), s_magic, sizeof(s_magic));
+        qToLittleEndian<quint32>(s_version, reinterpret_cast<uchar *>(bytes.data()) + sizeof(s_magic));
+    }
+
+    const QByteArray id = storageId.toUtf8().left(0xffff);
+    const int offset = bytes.size();
+    bytes.resize(offset + s_recordHeaderSize);
+    uchar *record = reinterpret_cast<uchar *>(bytes.data()) + offset;
+    qToLittleEndian<quint32>(stats.count, record);
+    qToLittleEndian<qint64>(stats.lastUsed, record + 4);
+    qToLittleEndian<quint16>(id.size(), record + 12);
+    bytes += id;
+
+    return file.write(bytes) == bytes.size();
+}
+
+void LaunchHistory::compact()
+{
+    // called with the write lock held
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QByteArray bytes(s_headerSize, '\0');
+    memcpy(bytes.data(), s_magic, sizeof(s_magic));
+    qToLittleEndian<quint32>(s_version, reinterpret_cast<uchar *>(bytes.data()) + sizeof(s_magic));
+
+    QHashIterator<QString, Stats> it(m_stats);
+    while (it.hasNext()) {
+        it.next();
+        const QByteArray id = it.key().toUtf8().left(0xffff);
+        const int offset = bytes.size();
+        bytes.resize(offset + s_recordHeaderSize);
+        uchar *record = reinterpret_cast<uchar *>(bytes.data()) + offset;
+        qToLittleEndian<quint32>(it.value().count, record);
+        qToLittleEndian<qint64>(it.value().lastUsed, record + 4);
+        qToLittleEndian<quint16>(id.size(), record + 12);
+        bytes += id;
+    }
+
+    file.write(bytes);
+    if (file.commit()) {
+        m_records = m_stats.count();
+    }
+}
+
+qreal LaunchHistory::score(const Stats &stats, qint64 now)
+{
+    const qreal age = qMax(qint64(0), now - stats.lastUsed);
+    return stats.count * std::pow(qreal(0.5), age / s_halfLife);
+}
+
+LaunchHistory::Boosts LaunchHistory::boosts() const
+{
+    QReadLocker lock(&m_lock);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    Boosts boosts;
+    boosts.reserve(m_stats.count());
+    QHashIterator<QString, Stats> it(m_stats);
+    while (it.hasNext()) {
+        it.next();
+        const qreal value = score(it.value(), now);
+        boosts.insert(it.key(), value / (value + 1));
+    }
+
+    return boosts;
+}
+
+QStringList LaunchHistory::mostLaunched(int count) const
+{
+    QReadLocker lock(&m_lock);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    QVector<QPair<qreal, QString> > scored;
+    scored.reserve(m_stats.count());
+    QHashIterator<QString, Stats> it(m_stats);
+    while (it.hasNext()) {
+        it.next();
+        scored << qMakePair(-score(it.value(), now), it.key());
+    }
+
+    const int top = qMin(count, scored.count());
+    std::partial_sort(scored.begin(), scored.begin() + top, scored.end());
+
+    QStringList storageIds;
+    for (int i = 0; i < top; ++i) {
+        storageIds << scored[i].second;
+    }
+
+    return storageIds;
+}
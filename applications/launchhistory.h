@@ -0,0 +1,83 @@
+/*
+ *   Copyright (C) 2026 the Sprinter plugins contributors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef LAUNCHHISTORY_H
+#define LAUNCHHISTORY_H
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringList>
+
+/**
+ * Remembers how often and how recently each service was launched, so that
+ * ranking can favour the applications a user actually runs.
+ *
+ * The history is kept in a compact, append-only log: every launch appends
+ * one record, and loading maps the file and folds the records into a hash.
+ * Once the log holds many more records than services it is compacted into
+ * one record per service.
+ */
+class LaunchHistory
+{
+public:
+    explicit LaunchHistory(const QString &path = defaultPath());
+
+    static QString defaultPath();
+
+    void recordLaunch(const QString &storageId);
+
+    typedef QHash<QString, qreal> Boosts;
+
+    /**
+     * @return a boost between 0 and 1 per launched storage id, that grows
+     * with the number of launches and fades as they age. The copy is taken
+     * once, so it can be read from any number of threads without locking.
+     */
+    Boosts boosts() const;
+
+    /**
+     * @return up to @p count storage ids, the most boosted first
+     */
+    QStringList mostLaunched(int count) const;
+
+private:
+    struct Stats
+    {
+        Stats()
+            : count(0),
+              lastUsed(0)
+        {
+        }
+
+        quint32 count;
+        qint64 lastUsed;
+    };
+
+    void load();
+    void compact();
+    bool append(const QString &storageId, const Stats &stats, bool truncate);
+    static qreal score(const Stats &stats, qint64 now);
+
+    const QString m_path;
+    mutable QReadWriteLock m_lock;
+    QHash<QString, Stats> m_stats;
+    int m_records;
+};
+
+#endif
@@ -23,47 +23,254 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QEventLoop>
-#include <QProcess>
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
 
-#include <KUser>
 #include <KAuth>
+#include <KFormat>
 
-#include "ksysguard/processes.h"
-#include "ksysguard/process.h"
+#include <algorithm>
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "processterminator.h"
+#include "socketindex.h"
+
+// a snapshot older than this is refreshed in the background on the next query
+static const int s_maxSnapshotAge = 5000;
+
+// how often cpu and memory usage of the shown processes are refreshed
+static const int s_updateInterval = 1000;
+
+// how much resident memory weighs as much as one percent of cpu in the ranking
+static const qint64 s_rssPerCpuPercent = 16 * 1024 * 1024;
+
+// the least time between two reads of the fds of all processes
+static const int s_socketRescanInterval = 10000;
+
+static double resourceScore(const ProcessInfo &process)
+{
+    return process.cpu + double(process.rss) / s_rssPerCpuPercent;
+}
 
 KillSessionData::KillSessionData(Sprinter::Runner *runner)
     : Sprinter::RunnerSessionData(runner),
-      m_processes(0)
+      m_table(new ProcessTable(this)),
+      m_updateTimer(new QTimer(this)),
+      m_waiting(false)
 {
+    m_updateTimer->setInterval(s_updateInterval);
+    connect(m_updateTimer, SIGNAL(timeout()), this, SLOT(performUpdate()));
+    connect(m_table, SIGNAL(snapshotChanged()), this, SLOT(snapshotChanged()));
+    connect(m_table, SIGNAL(usersResolved()), this, SLOT(updateMatchTexts()));
+    m_table->refresh();
+
+    KillRunner *kr = qobject_cast<KillRunner *>(runner);
+    if (kr) {
+        connect(kr->terminator(), SIGNAL(terminated(quint64)), this, SLOT(processTerminated()));
+    }
+}
+
+ProcessTable *KillSessionData::table() const
+{
+    return m_table;
 }
 
-KillSessionData::~KillSessionData()
+void KillSessionData::startUpdating()
 {
-    delete m_processes;
+    QMetaObject::invokeMethod(m_updateTimer, "start");
 }
 
-void KillSessionData::updateProcessTable()
+bool KillSessionData::shouldStartMatch(const Sprinter::QueryContext &context) const
 {
-    const bool update = !m_processes || m_lastUpdate.elapsed() > 5000;
-    if (!m_processes) {
-        m_processes = new KSysGuard::Processes;
+    bool should = RunnerSessionData::shouldStartMatch(context);
+    if (!should) {
+        QMetaObject::invokeMethod(m_updateTimer, "stop");
     }
+    return should;
+}
+
+void KillSessionData::setContext(const Sprinter::QueryContext &context)
+{
+    QMutexLocker lock(&m_contextLock);
+    m_context = context;
+}
 
-    if (update) {
-        m_processes->updateAllProcesses();
-        m_lastUpdate.restart();
+void KillSessionData::matchWhenReady(const Sprinter::QueryContext &context)
+{
+    QMutexLocker lock(&m_contextLock);
+    m_context = context;
+    m_waiting = true;
+}
+
+void KillSessionData::stopWaiting()
+{
+    QMutexLocker lock(&m_contextLock);
+    m_waiting = false;
+}
+
+void KillSessionData::snapshotChanged()
+{
+    QMutexLocker lock(&m_contextLock);
+    const Sprinter::QueryContext context = m_context;
+    const bool waiting = m_waiting;
+    m_waiting = false;
+    lock.unlock();
+
+    KillRunner *kr = qobject_cast<KillRunner *>(runner());
+    if (!waiting) {
+        if (m_updateTimer->isActive()) {
+            updateMatchTexts();
+        }
+        return;
+    }
+
+    if (!kr || !context.isValid(this)) {
+        return;
     }
+
+    QVector<Sprinter::QueryMatch> matches;
+    kr->performMatch(this, *m_table->snapshot(), context, matches);
+    setMatches(matches, context);
+}
+
+void KillSessionData::performUpdate()
+{
+    // the matches are brought up to date once the new snapshot is in
+    m_table->refresh();
+}
+
+void KillSessionData::updateMatchTexts()
+{
+    KillRunner *kr = qobject_cast<KillRunner *>(runner());
+    const std::shared_ptr<const ProcessSnapshot> snapshot = m_table->snapshot();
+    if (!kr || !snapshot) {
+        return;
+    }
+
+    // fills in cpu and memory usage, and the user names that were shown as
+    // uids; processes that are gone, or whose pid was reused, are dropped
+    const std::shared_ptr<const UserNames> userNames = m_table->userNames();
+    const QVector<Sprinter::QueryMatch> current = matches(SynchronizedMatches);
+    if (current.isEmpty()) {
+        m_updateTimer->stop();
+        return;
+    }
+
+    QMutexLocker lock(&m_contextLock);
+    const Sprinter::QueryContext context = m_context;
+    lock.unlock();
+
+    QHash<quint64, int> processes;
+    processes.reserve(snapshot->processes.count());
+    for (int i = 0; i < snapshot->processes.count(); ++i) {
+        processes.insert(snapshot->processes[i].pid, i);
+    }
+
+    auto find = [&](const QVariant &pid, const QVariant &startTime) -> const ProcessInfo * {
+        auto process = processes.constFind(pid.toULongLong());
+        if (process == processes.constEnd() ||
+            snapshot->processes[*process].startTime != startTime.toULongLong()) {
+            return 0;
+        }
+        return &snapshot->processes[*process];
+    };
+
+    QVector<Sprinter::QueryMatch> remaining;
+    QVector<Sprinter::QueryMatch> updates;
+    bool rebuilt = false;
+    foreach (Sprinter::QueryMatch match, current) {
+        const QVariantList data = match.data().value<QVariantList>();
+        const QVariantList pids = data.value(0).toList();
+        const QVariantList startTimes = data.value(1).toList();
+        if (pids.count() > 1) {
+            // the match for all processes keeps the ones still running
+            QVector<const ProcessInfo *> alive;
+            for (int i = 0; i < pids.count(); ++i) {
+                const ProcessInfo *process = find(pids[i], startTimes.value(i));
+                if (process) {
+                    alive << process;
+                }
+            }
+
+            if (alive.count() < 2 || !context.isValid(this)) {
+                rebuilt = true;
+                continue;
+            }
+
+            const Sprinter::QueryMatch killAll = kr->createKillAllMatch(alive, context);
+            if (alive.count() != pids.count()) {
+                rebuilt = true;
+                remaining << killAll;
+                continue;
+            }
+
+            if (killAll.text() != match.text()) {
+                match.setText(killAll.text());
+                updates << match;
+            }
+            remaining << match;
+            continue;
+        }
+
+        const ProcessInfo *process = pids.count() == 1 ? find(pids[0], startTimes.value(0)) : 0;
+        if (!process || data.count() < 3) {
+            rebuilt = true;
+            continue;
+        }
+
+        const qlonglong uid = data[2].toLongLong();
+        auto userName = userNames->constFind(uid);
+        const QString text = kr->processText(*process,
+                                             userName == userNames->constEnd() ? QString::number(uid)
+                                                                               : *userName);
+        if (text != match.text()) {
+            match.setText(text);
+            updates << match;
+        }
+        remaining << match;
+    }
+
+    if (rebuilt) {
+        // the set of matches changed, which updates can not express
+        if (context.isValid(this)) {
+            setMatches(remaining, context);
+        }
+    } else if (!updates.isEmpty()) {
+        updateMatches(updates);
+    }
+}
+
+void KillSessionData::processTerminated()
+{
+    // drop it from the table right away rather than in up to five seconds
+    m_table->refresh();
 }
 
 KillRunner::KillRunner(QObject *parent)
         : Sprinter::Runner(parent),
           m_triggerWord(i18n("kill ")),
-          m_icon(QIcon::fromTheme("application-exit"))
+          m_icon(QIcon::fromTheme("application-exit")),
+          m_terminator(new ProcessTerminator)
 {
+    // exec() may be called from any thread, but the processes are followed
+    // from the main event loop
+    m_terminator->moveToThread(QCoreApplication::instance()->thread());
 }
 
 KillRunner::~KillRunner()
 {
+    // its notifiers and timer belong to the main thread; deleteLater() is
+    // only needed from elsewhere, as it never runs once that event loop
+    // is gone, leaking the pidfds being watched
+    if (m_terminator->thread() == QThread::currentThread()) {
+        delete m_terminator;
+    } else {
+        m_terminator->deleteLater();
+    }
 }
 
 Sprinter::RunnerSessionData *KillRunner::createSessionData()
@@ -78,89 +285,311 @@ void KillRunner::match(Sprinter::MatchData &matchData)
         return;
     }
 
-    QString term = matchData.queryContext().query();
+    const QString term = matchData.queryContext().query();
     if (!term.startsWith(m_triggerWord, Qt::CaseInsensitive)) {
         return;
     }
 
-    QMetaObject::invokeMethod(matchData.sessionData(), "updateProcessTable",
-                              Qt::BlockingQueuedConnection);
-    term = term.right(term.length() - m_triggerWord.length());
+    sessionData->setContext(matchData.queryContext());
+
+    // never wait for the process table: use whatever snapshot is current and
+    // let the worker bring it up to date in the background
+    sessionData->table()->refresh(s_maxSnapshotAge);
+    std::shared_ptr<const ProcessSnapshot> snapshot = sessionData->table()->snapshot();
+    if (!snapshot) {
+        // the first snapshot may be published right between the check above
+        // and this call, so look again once the query is remembered
+        sessionData->matchWhenReady(matchData.queryContext());
+        snapshot = sessionData->table()->snapshot();
+        if (!snapshot) {
+            return;
+        }
+
+        sessionData->stopWaiting();
+    }
+
+    QVector<Sprinter::QueryMatch> matches;
+    performMatch(sessionData, *snapshot, matchData.queryContext(), matches);
+    foreach (const Sprinter::QueryMatch &match, matches) {
+        matchData << match;
+    }
+}
 
+void KillRunner::performMatch(KillSessionData *sessionData, const ProcessSnapshot &snapshot,
+                              const Sprinter::QueryContext &context,
+                              QVector<Sprinter::QueryMatch> &matches)
+{
+    const QString term = queryTerm(context);
     if (term.length() < 2)  {
         return;
     }
-    const QList<KSysGuard::Process *> processlist = sessionData->m_processes->getAllProcesses();
-    for (auto process: processlist) {
-        if (!matchData.isValid()) {
-            return;
+
+    // ":PORT" looks for the owners of the sockets on that port, anything
+    // else is searched in names, command lines and executables all at once
+    bool isPort = false;
+    const quint16 port = term.startsWith(':') ? term.mid(1).toUShort(&isPort) : 0;
+    const QVector<ProcessSnapshot::Match> hits =
+        isPort ? findPortOwners(sessionData, snapshot, context, port)
+               : snapshot.find(term.toCaseFolded().toUtf8());
+
+    // only the processes up to the end of the requested page are ranked,
+    // keeping the best ones in a min-heap on their resource score
+    const int offset = sessionData->resultsOffset();
+    const int limit = offset + sessionData->resultsPageSize();
+    auto ranksHigher = [&snapshot](const ProcessSnapshot::Match &a, const ProcessSnapshot::Match &b) {
+        return resourceScore(snapshot.processes[a.index]) > resourceScore(snapshot.processes[b.index]);
+    };
+
+    QVector<ProcessSnapshot::Match> ranked;
+    ranked.reserve(qMin(limit, hits.count()));
+    for (const ProcessSnapshot::Match &hit: hits) {
+        if (ranked.count() < limit) {
+            ranked << hit;
+            std::push_heap(ranked.begin(), ranked.end(), ranksHigher);
+        } else if (limit > 0 && ranksHigher(hit, ranked.front())) {
+            std::pop_heap(ranked.begin(), ranked.end(), ranksHigher);
+            ranked.back() = hit;
+            std::push_heap(ranked.begin(), ranked.end(), ranksHigher);
         }
+    }
+    std::sort_heap(ranked.begin(), ranked.end(), ranksHigher);
 
-        const QString name = process->name;
-        if (!name.contains(term, Qt::CaseInsensitive)) {
-            //Process doesn't match the search term
-            continue;
+    if (hits.count() > limit) {
+        sessionData->setCanFetchMoreMatches(true, context);
+    }
+
+    // user names are never looked up here; unknown ones are shown as uids
+    // until the table has resolved them
+    const std::shared_ptr<const UserNames> userNames = sessionData->table()->userNames();
+    QSet<qlonglong> unresolved;
+    for (int i = offset; i < ranked.count(); ++i) {
+        if (!context.isValid(sessionData)) {
+            return;
         }
 
-        const quint64 pid = process->pid;
-        const qlonglong uid = process->uid;
-        const QString user = getUserName(uid);
+        const ProcessSnapshot::Match &hit = ranked[i];
+        const ProcessInfo &process = snapshot.processes[hit.index];
+        const QString &name = process.name;
+        const quint64 pid = process.pid;
+        const qlonglong uid = process.uid;
+        auto userName = userNames->constFind(uid);
+        if (userName == userNames->constEnd()) {
+            unresolved.insert(uid);
+        }
 
         QVariantList data;
-        data << pid << user;
+        data << QVariant(QVariantList() << pid)
+             << QVariant(QVariantList() << process.startTime)
+             << uid;
 
         Sprinter::QueryMatch match;
         match.setTitle(i18n("Terminate %1", name));
-        match.setText(i18n("Process ID: %1\nRunning as user: %2", QString::number(pid), user));
-        match.setImage(generateImage(m_icon, matchData.queryContext()));
+        match.setText(processText(process, userName == userNames->constEnd() ? QString::number(uid)
+                                                                             : *userName));
+        match.setImage(generateImage(m_icon, context));
         match.setUserData(QStringLiteral("kill -9 ") + pid);
         match.setData(data);
         match.setType(Sprinter::QuerySession::AppActionType);
         match.setSource(Sprinter::QuerySession::FromLocalService);
-        matchData << match;
+        if (isPort) {
+            match.setPrecision(Sprinter::QuerySession::ExactMatch);
+        } else if (!hit.inName) {
+            // only the command line or executable matched
+            match.setPrecision(Sprinter::QuerySession::FuzzyMatch);
+        } else if (name.compare(term, Qt::CaseInsensitive) == 0) {
+            match.setPrecision(Sprinter::QuerySession::ExactMatch);
+        } else {
+            match.setPrecision(Sprinter::QuerySession::CloseMatch);
+        }
+        matches << match;
+    }
+
+    if (!matches.isEmpty()) {
+        sessionData->startUpdating();
+    }
+
+    if (!unresolved.isEmpty()) {
+        QVariantList uids;
+        foreach (qlonglong uid, unresolved) {
+            uids << uid;
+        }
+        sessionData->table()->resolveUsers(uids);
+    }
+
+    if (offset > 0 || hits.count() < 2) {
+        return;
+    }
+
+    // a match for all of them goes on the first page
+    QVector<const ProcessInfo *> all;
+    for (const ProcessSnapshot::Match &hit: hits) {
+        const ProcessInfo &process = snapshot.processes[hit.index];
+
+        // never take ourselves down along with the others
+        if (process.pid != quint64(QCoreApplication::applicationPid())) {
+            all << &process;
+        }
+    }
+
+    if (all.count() > 1) {
+        matches << createKillAllMatch(all, context);
     }
 }
 
+QVector<ProcessSnapshot::Match> KillRunner::findPortOwners(KillSessionData *sessionData,
+                                                          const ProcessSnapshot &snapshot,
+                                                          const Sprinter::QueryContext &context,
+                                                          quint16 port)
+{
+    QVector<ProcessSnapshot::Match> hits;
+    const QSet<quint64> sockets = SocketIndex::socketsOnPort(port);
+    if (sockets.isEmpty()) {
+        return hits;
+    }
+
+    QSet<quint64> pids;
+    bool missing = false;
+    foreach (quint64 inode, sockets) {
+        auto owner = snapshot.socketOwners.constFind(inode);
+        if (owner == snapshot.socketOwners.constEnd()) {
+            missing = true;
+        } else {
+            pids.insert(*owner);
+        }
+    }
+
+    // sockets that are not known yet belong to processes whose fds were read
+    // before they opened them, or that we may not look into; read all fds
+    // again, though not too often, and answer again when that is done
+    if (missing && (!snapshot.socketsRescanned.isValid() ||
+                    snapshot.socketsRescanned.hasExpired(s_socketRescanInterval))) {
+        sessionData->matchWhenReady(context);
+        sessionData->table()->rescanSockets();
+    }
+
+    for (int i = 0; i < snapshot.processes.count() && !pids.isEmpty(); ++i) {
+        if (pids.remove(snapshot.processes[i].pid)) {
+            ProcessSnapshot::Match hit;
+            hit.index = i;
+            hit.inName = false;
+            hits << hit;
+        }
+    }
+
+    return hits;
+}
+
 bool KillRunner::exec(const Sprinter::QueryMatch &match)
 {
-    QVariantList data = match.data().value<QVariantList>();
-    quint64 pid = data[0].toUInt();
-    QString user = data[1].toString();
+    const QVariantList data = match.data().value<QVariantList>();
+    const QVariantList pids = data.value(0).toList();
+    const QVariantList startTimes = data.value(1).toList();
+    if (pids.isEmpty()) {
+        return false;
+    }
 
-    int signal = 9; //default: SIGKILL
+    const int signal = m_terminator->initialSignal();
 
-    QStringList args;
-    args << QString("-%1").arg(signal) << QString("%1").arg(pid);
-    QProcess process;
-    process.setProgram(QStringLiteral("kill"));
-    process.setArguments(args);
-    process.start();
-    process.waitForFinished();
-    if (process.exitCode() == 0) {
-        return true;
+    // signal what we may directly and collect the rest for a single
+    // authorization round trip; either way the processes are followed
+    // until they are gone, without blocking here
+    QVariantList denied;
+    QHash<int, quint64> deniedFds;
+    for (int i = 0; i < pids.count(); ++i) {
+        const quint64 pid = pids[i].toULongLong();
+        int pidfd;
+        const int result = ProcessTerminator::sendSignal(pid, startTimes.value(i).toULongLong(),
+                                                         signal, &pidfd);
+        if (result == EPERM) {
+            denied << pid;
+            if (pidfd != -1) {
+                deniedFds.insert(pidfd, pid);
+            }
+        } else if (pidfd != -1) {
+            QMetaObject::invokeMethod(m_terminator, "watch", Qt::QueuedConnection,
+                                      Q_ARG(int, pidfd), Q_ARG(quint64, pid),
+                                      Q_ARG(bool, false));
+        }
     }
 
-    KAuth::Action *killAction =
-        new KAuth::Action("org.kde.ksysguard.processlisthelper.sendsignal");
-    killAction->setHelperId("org.kde.ksysguard.processlisthelper");
-    killAction->addArgument("pid0", pid);
-    killAction->addArgument("pidcount", 1);
-    killAction->addArgument("signal", signal);
+    if (denied.isEmpty()) {
+        return true;
+    }
 
     bool success = false;
     QEventLoop loop;
-    KAuth::ExecuteJob *job = killAction->execute();
+    KAuth::ExecuteJob *job = ProcessTerminator::sendSignalAsRoot(denied, signal);
     job->moveToThread(QCoreApplication::instance()->thread());
     connect(job, &KJob::finished,
             [&]() { success = !job->error(); loop.exit(); });
     loop.exec();
+
+    // processes the user did not authorize killing are left alone; following
+    // them would ask again when escalating
+    for (auto it = deniedFds.constBegin(); it != deniedFds.constEnd(); ++it) {
+        if (success) {
+            QMetaObject::invokeMethod(m_terminator, "watch", Qt::QueuedConnection,
+                                      Q_ARG(int, it.key()), Q_ARG(quint64, it.value()),
+                                      Q_ARG(bool, true));
+        } else {
+            close(it.key());
+        }
+    }
+
     return success;
 }
 
-QString KillRunner::getUserName(qlonglong uid)
+ProcessTerminator *KillRunner::terminator() const
 {
-    KUser user(uid);
-    return user.isValid() ? user.loginName() : "root";
+    return m_terminator;
+}
+
+QString KillRunner::queryTerm(const Sprinter::QueryContext &context) const
+{
+    const QString query = context.query();
+    return query.right(query.length() - m_triggerWord.length());
+}
+
+Sprinter::QueryMatch KillRunner::createKillAllMatch(const QVector<const ProcessInfo *> &processes,
+                                                    const Sprinter::QueryContext &context)
+{
+    QVariantList pids;
+    QVariantList startTimes;
+    QStringList pidStrings;
+    double cpu = 0;
+    qint64 rss = 0;
+    foreach (const ProcessInfo *process, processes) {
+        pids << process->pid;
+        startTimes << process->startTime;
+        pidStrings << QString::number(process->pid);
+        cpu += process->cpu;
+        rss += process->rss;
+    }
+
+    Sprinter::QueryMatch match;
+    match.setTitle(i18n("Terminate all %1 processes matching \"%2\"", processes.count(), queryTerm(context)));
+    match.setText(i18n("Process IDs: %1\nCPU: %2%, memory: %3", pidStrings.join(QStringLiteral(", ")),
+                       QString::number(cpu, 'f', 1), KFormat().formatByteSize(rss)));
+    match.setImage(generateImage(m_icon, context));
+    match.setUserData(QStringLiteral("kill -9 ") + pidStrings.join(QStringLiteral(" ")));
+    match.setData(QVariantList() << QVariant(pids) << QVariant(startTimes));
+    match.setType(Sprinter::QuerySession::AppActionType);
+    match.setSource(Sprinter::QuerySession::FromLocalService);
+    match.setPrecision(Sprinter::QuerySession::CloseMatch);
+    return match;
+}
+
+QString KillRunner::processText(const ProcessInfo &process, const QString &user) const
+{
+    const QString cpu = QString::number(process.cpu, 'f', 1);
+    const QString memory = KFormat().formatByteSize(process.rss);
+    if (process.command.isEmpty()) {
+        return i18n("Process ID: %1\nRunning as user: %2\nCPU: %3%, memory: %4",
+                    QString::number(process.pid), user, cpu, memory);
+    }
+
+    return i18n("Process ID: %1\nRunning as user: %2\nCPU: %3%, memory: %4\nCommand: %5",
+                QString::number(process.pid), user, cpu, memory, process.command);
 }
 
 #include "moc_kill.cpp"
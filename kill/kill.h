@@ -22,15 +22,15 @@
 #define KILLRUNNER_H
 
 #include <QIcon>
-#include <QTime>
+#include <QMutex>
 
 #include <Sprinter/Runner>
 
-namespace KSysGuard
-{
-    class Processes;
-    class Process;
-}
+#include "processtable.h"
+
+class QTimer;
+
+class ProcessTerminator;
 
 class KillSessionData : public Sprinter::RunnerSessionData
 {
@@ -38,15 +38,46 @@ class KillSessionData : public Sprinter::RunnerSessionData
 
 public:
     KillSessionData(Sprinter::Runner *runner);
-    ~KillSessionData();
-
-    KSysGuard::Processes *m_processes;
 
-public Q_SLOTS:
-    void updateProcessTable();
+    ProcessTable *table() const;
+
+    /**
+     * Keeps cpu and memory usage of the shown processes up to date, until
+     * none are shown anymore
+     */
+    void startUpdating();
+    bool shouldStartMatch(const Sprinter::QueryContext &context) const;
+
+    /**
+     * Remembers the context of the latest query, so the matches shown for
+     * it can be kept up to date as processes change
+     */
+    void setContext(const Sprinter::QueryContext &context);
+
+    /**
+     * Remembers a query that arrived before the first process table was
+     * ready; it is answered as soon as the table comes in
+     */
+    void matchWhenReady(const Sprinter::QueryContext &context);
+
+    /**
+     * Forgets the query remembered by matchWhenReady(), once it was answered
+     * after all
+     */
+    void stopWaiting();
+
+private Q_SLOTS:
+    void snapshotChanged();
+    void performUpdate();
+    void updateMatchTexts();
+    void processTerminated();
 
 private:
-    QTime m_lastUpdate;
+    ProcessTable *m_table;
+    QTimer *m_updateTimer;
+    QMutex m_contextLock;
+    Sprinter::QueryContext m_context;
+    bool m_waiting;
 };
 
 class KillRunner : public Sprinter::Runner
@@ -64,15 +95,45 @@ public:
     void match(Sprinter::MatchData &matchData);
     bool exec(const Sprinter::QueryMatch &match);
 
+    /**
+     * Matches the query in @p context against the processes in @p snapshot
+     */
+    void performMatch(KillSessionData *sessionData, const ProcessSnapshot &snapshot,
+                      const Sprinter::QueryContext &context,
+                      QVector<Sprinter::QueryMatch> &matches);
+
+    /**
+     * @return a match that terminates all of @p processes at once
+     */
+    Sprinter::QueryMatch createKillAllMatch(const QVector<const ProcessInfo *> &processes,
+                                            const Sprinter::QueryContext &context);
+
+    ProcessTerminator *terminator() const;
+
+    /**
+     * @return the description shown for @p process, running as @p user
+     */
+    QString processText(const ProcessInfo &process, const QString &user) const;
+
 private:
-    /** @param uid the uid of the user
-      * @return the username of the user with the UID uid
-      */
-    QString getUserName(qlonglong uid);
+    /**
+     * @return the query in @p context without the trigger word
+     */
+    QString queryTerm(const Sprinter::QueryContext &context) const;
+
+    /**
+     * @return the processes owning a listening TCP or a bound UDP socket
+     * on @p port
+     */
+    QVector<ProcessSnapshot::Match> findPortOwners(KillSessionData *sessionData,
+                                                   const ProcessSnapshot &snapshot,
+                                                   const Sprinter::QueryContext &context,
+                                                   quint16 port);
 
     /** The trigger word */
     const QString m_triggerWord;
     QIcon m_icon;
+    ProcessTerminator *m_terminator;
 };
 
 #endif
\ No newline at end of file
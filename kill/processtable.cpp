@@ -0,0 +1,267 @@
+/* Copyright 2009  Jan Gerrit Marker <jangerrit@weiler-marker.com>
+ * Copyright 2014  Aaron Seigo <aseigo@kde.org>
+ * Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "processtable.h"
+
+#include <algorithm>
+
+#include <KUser>
+
+#include "socketindex.h"
+
+#include <string.h>
+
+#ifdef HAVE_PROCSCANNER
+#include "procscanner.h"
+#else
+#include "ksysguard/processes.h"
+#include "ksysguard/process.h"
+#endif
+
+void ProcessSnapshot::index()
+{
+    text.clear();
+    textOffsets.clear();
+    nameLengths.clear();
+    textOffsets.reserve(processes.count() + 1);
+    nameLengths.reserve(processes.count());
+
+    for (const ProcessInfo &process: processes) {
+        textOffsets << text.size();
+        const QByteArray name = process.name.toCaseFolded().toUtf8();
+        nameLengths << name.size();
+        text += name;
+        text += '\0';
+        text += process.command.toCaseFolded().toUtf8();
+        text += '\0';
+        text += process.executable.toCaseFolded().toUtf8();
+        text += '\0';
+    }
+
+    textOffsets << text.size();
+}
+
+QVector<ProcessSnapshot::Match> ProcessSnapshot::find(const QByteArray &foldedTerm) const
+{
+    QVector<Match> matches;
+    const int length = foldedTerm.size();
+    if (length == 0) {
+        return matches;
+    }
+
+    // look for the first byte of the term with memchr, which is vectorized,
+    // and only compare the rest where it is found
+    const char first = foldedTerm[0];
+    const char *begin = text.constData();
+    const char *end = begin + text.size();
+    const char *pos = begin;
+    while (end - pos >= length) {
+        pos = static_cast<const char *>(memchr(pos, first, end - pos - length + 1));
+        if (!pos) {
+            break;
+        }
+
+        if (memcmp(pos + 1, foldedTerm.constData() + 1, length - 1) != 0) {
+            ++pos;
+            continue;
+        }
+
+        const int offset = pos - begin;
+        const int index = std::upper_bound(textOffsets.constBegin(), textOffsets.constEnd(), offset) -
+                          textOffsets.constBegin() - 1;
+        Match match;
+        match.index = index;
+        match.inName = offset < textOffsets[index] + nameLengths[index];
+        matches << match;
+
+        // the name comes first, so the first hit is the best one; move on
+        pos = begin + textOffsets[index + 1];
+    }
+
+    return matches;
+}
+
+ProcessTableWorker::ProcessTableWorker(ProcessTable *table)
+    : QObject(),
+      m_table(table),
+#ifdef HAVE_PROCSCANNER
+      m_scanner(0),
+#else
+      m_processes(0),
+#endif
+      m_sockets(0)
+{
+}
+
+ProcessTableWorker::~ProcessTableWorker()
+{
+#ifdef HAVE_PROCSCANNER
+    delete m_scanner;
+#else
+    delete m_processes;
+#endif
+    delete m_sockets;
+}
+
+void ProcessTableWorker::refresh()
+{
+    std::shared_ptr<ProcessSnapshot> snapshot(new ProcessSnapshot);
+
+#ifdef HAVE_PROCSCANNER
+    if (!m_scanner) {
+        m_scanner = new ProcScanner;
+    }
+
+    m_scanner->scan(snapshot->processes);
+#else
+    if (!m_processes) {
+        m_processes = new KSysGuard::Processes;
+    }
+
+    m_processes->updateAllProcesses();
+
+    const QList<KSysGuard::Process *> processlist = m_processes->getAllProcesses();
+    snapshot->processes.reserve(processlist.count());
+    for (auto process: processlist) {
+        ProcessInfo info;
+        info.pid = process->pid;
+        info.uid = process->uid;
+        info.startTime = 0;
+        info.cpuTime = 0;
+        info.cpu = process->userUsage + process->sysUsage;
+        info.rss = process->vmRSS * 1024;
+        info.name = process->name;
+        info.command = process->command;
+        snapshot->processes << info;
+    }
+#endif
+
+    if (m_table->m_trackSockets.loadAcquire()) {
+        if (!m_sockets) {
+            m_sockets = new SocketIndex;
+        }
+
+        const bool rescan = m_table->m_rescanSockets.fetchAndStoreOrdered(0);
+        m_sockets->update(snapshot->processes, rescan);
+        if (rescan) {
+            m_socketsRescanned.start();
+        }
+        snapshot->socketOwners = m_sockets->owners();
+        snapshot->socketsRescanned = m_socketsRescanned;
+    }
+
+    snapshot->index();
+    snapshot->age.start();
+
+    m_table->publish(snapshot);
+}
+
+void ProcessTableWorker::resolveUsers(const QVariantList &uids)
+{
+    // several queries may have asked for the same users before we got here
+    const std::shared_ptr<const UserNames> current = m_table->userNames();
+    std::shared_ptr<UserNames> userNames;
+    foreach (const QVariant &uid, uids) {
+        const qlonglong id = uid.toLongLong();
+        if (current->contains(id) || (userNames && userNames->contains(id))) {
+            continue;
+        }
+
+        if (!userNames) {
+            userNames.reset(new UserNames(*current));
+        }
+
+        KUser user(K_UID(id));
+        userNames->insert(id, user.isValid() ? user.loginName() : QStringLiteral("root"));
+    }
+
+    if (userNames) {
+        m_table->publish(std::shared_ptr<const UserNames>(userNames));
+    }
+}
+
+ProcessTable::ProcessTable(QObject *parent)
+    : QObject(parent),
+      m_worker(new ProcessTableWorker(this)),
+      m_userNames(new UserNames)
+{
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, SIGNAL(finished()), m_worker, SLOT(deleteLater()));
+    m_thread.start(QThread::LowPriority);
+}
+
+ProcessTable::~ProcessTable()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+std::shared_ptr<const ProcessSnapshot> ProcessTable::snapshot() const
+{
+    return std::atomic_load(&m_snapshot);
+}
+
+void ProcessTable::refresh(int maxAge)
+{
+    if (maxAge > 0) {
+        const std::shared_ptr<const ProcessSnapshot> current = snapshot();
+        if (current && !current->age.hasExpired(maxAge)) {
+            return;
+        }
+    }
+
+    if (m_refreshQueued.testAndSetOrdered(0, 1)) {
+        QMetaObject::invokeMethod(m_worker, "refresh", Qt::QueuedConnection);
+    }
+}
+
+std::shared_ptr<const UserNames> ProcessTable::userNames() const
+{
+    return std::atomic_load(&m_userNames);
+}
+
+void ProcessTable::resolveUsers(const QVariantList &uids)
+{
+    QMetaObject::invokeMethod(m_worker, "resolveUsers", Qt::QueuedConnection,
+                              Q_ARG(QVariantList, uids));
+}
+
+void ProcessTable::rescanSockets()
+{
+    m_trackSockets.storeRelease(1);
+    m_rescanSockets.storeRelease(1);
+    refresh();
+}
+
+void ProcessTable::publish(const std::shared_ptr<const ProcessSnapshot> &snapshot)
+{
+    std::atomic_store(&m_snapshot, snapshot);
+    m_refreshQueued.storeRelease(0);
+    emit snapshotChanged();
+}
+
+void ProcessTable::publish(const std::shared_ptr<const UserNames> &userNames)
+{
+    std::atomic_store(&m_userNames, userNames);
+    emit usersResolved();
+}
+
+#include "moc_processtable.cpp"
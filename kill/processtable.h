@@ -0,0 +1,193 @@
+/* Copyright 2009  Jan Gerrit Marker <jangerrit@weiler-marker.com>
+ * Copyright 2014  Aaron Seigo <aseigo@kde.org>
+ * Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROCESSTABLE_H
+#define PROCESSTABLE_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QVariantList>
+#include <QVector>
+
+#include <memory>
+
+#ifdef HAVE_PROCSCANNER
+class ProcScanner;
+#else
+namespace KSysGuard
+{
+    class Processes;
+}
+#endif
+
+class ProcessTable;
+class SocketIndex;
+
+typedef QHash<qlonglong, QString> UserNames;
+
+struct ProcessInfo
+{
+    quint64 pid;
+    qlonglong uid;
+    // in clock ticks after boot, as in /proc/[pid]/stat; 0 if unknown
+    quint64 startTime;
+    // user and system time in clock ticks; 0 if unknown
+    quint64 cpuTime;
+    // percentage of one cpu used since the previous refresh
+    double cpu;
+    // resident memory in bytes
+    qint64 rss;
+    QString name;
+    QString command;
+    QString executable;
+};
+
+/**
+ * An immutable copy of the process table. Once published it is never
+ * modified, so any number of threads may read it without locking.
+ */
+struct ProcessSnapshot
+{
+    struct Match
+    {
+        int index;
+        bool inName;
+    };
+
+    /**
+     * Builds the search text from the processes
+     */
+    void index();
+
+    /**
+     * @return the processes whose name, command line or executable contain
+     * @p foldedTerm, the case folded UTF-8 search term
+     */
+    QVector<Match> find(const QByteArray &foldedTerm) const;
+
+    QVector<ProcessInfo> processes;
+    QElapsedTimer age;
+
+    // the case folded name, command line and executable of every process,
+    // each followed by a nul byte
+    QByteArray text;
+    // where the text of each process starts, followed by the end of the text
+    QVector<int> textOffsets;
+    QVector<int> nameLengths;
+
+    // the pid owning each socket inode; only filled in once sockets were asked for
+    QHash<quint64, quint64> socketOwners;
+    // when the fds of all processes were last read; invalid if never
+    QElapsedTimer socketsRescanned;
+};
+
+/**
+ * Refreshes the process table; lives in the thread owned by ProcessTable
+ */
+class ProcessTableWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    ProcessTableWorker(ProcessTable *table);
+    ~ProcessTableWorker();
+
+public Q_SLOTS:
+    void refresh();
+    void resolveUsers(const QVariantList &uids);
+
+private:
+    ProcessTable *m_table;
+#ifdef HAVE_PROCSCANNER
+    ProcScanner *m_scanner;
+#else
+    KSysGuard::Processes *m_processes;
+#endif
+    SocketIndex *m_sockets;
+    QElapsedTimer m_socketsRescanned;
+};
+
+/**
+ * Keeps an up to date snapshot of the running processes. Refreshing happens
+ * on a background thread; the latest snapshot is swapped in atomically, so
+ * readers never block on a refresh in progress.
+ */
+class ProcessTable : public QObject
+{
+    Q_OBJECT
+
+public:
+    ProcessTable(QObject *parent = 0);
+    ~ProcessTable();
+
+    /**
+     * @return the latest snapshot, or a null pointer if the first refresh
+     * has not finished yet
+     */
+    std::shared_ptr<const ProcessSnapshot> snapshot() const;
+
+    /**
+     * Schedules a refresh unless the current snapshot is younger than
+     * @p maxAge milliseconds. Never blocks; at most one refresh is queued
+     * at any time.
+     */
+    void refresh(int maxAge = 0);
+
+    /**
+     * @return the login names looked up so far, by uid
+     */
+    std::shared_ptr<const UserNames> userNames() const;
+
+    /**
+     * Looks up the login names of @p uids in the background, all in one go;
+     * usersResolved() is emitted once they are known. Never blocks.
+     */
+    void resolveUsers(const QVariantList &uids);
+
+    /**
+     * Makes the following refreshes track socket owners, starting with a
+     * read of the fds of all processes. Never blocks.
+     */
+    void rescanSockets();
+
+Q_SIGNALS:
+    void snapshotChanged();
+    void usersResolved();
+
+private:
+    friend class ProcessTableWorker;
+    void publish(const std::shared_ptr<const ProcessSnapshot> &snapshot);
+    void publish(const std::shared_ptr<const UserNames> &userNames);
+
+    QThread m_thread;
+    ProcessTableWorker *m_worker;
+    QAtomicInt m_refreshQueued;
+    QAtomicInt m_trackSockets;
+    QAtomicInt m_rescanSockets;
+    std::shared_ptr<const ProcessSnapshot> m_snapshot;
+    std::shared_ptr<const UserNames> m_userNames;
+};
+
+#endif
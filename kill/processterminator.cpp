@@ -0,0 +1,231 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "processterminator.h"
+#include "procstat.h"
+
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <KAuth>
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+
+// the same on all architectures; older C libraries don't define them
+#ifndef SYS_pidfd_send_signal
+#define SYS_pidfd_send_signal 424
+#endif
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#endif
+
+static const int s_defaultGracePeriod = 5000;
+
+ProcessTerminator::ProcessTerminator(QObject *parent)
+    : QObject(parent),
+      m_gracePeriod(KConfigGroup(KSharedConfig::openConfig("sprinterrc"), "Kill")
+                        .readEntry("GracePeriod", s_defaultGracePeriod)),
+      m_escalationTimer(new QTimer(this))
+{
+    m_escalationTimer->setSingleShot(true);
+    connect(m_escalationTimer, SIGNAL(timeout()), this, SLOT(escalate()));
+}
+
+ProcessTerminator::~ProcessTerminator()
+{
+    foreach (int pidfd, m_watches.keys()) {
+        close(pidfd);
+    }
+}
+
+int ProcessTerminator::gracePeriod() const
+{
+    return m_gracePeriod;
+}
+
+int ProcessTerminator::initialSignal() const
+{
+    return m_gracePeriod > 0 ? SIGTERM : SIGKILL;
+}
+
+int ProcessTerminator::sendSignal(quint64 pid, quint64 startTime, int signal, int *pidfd)
+{
+#ifdef Q_OS_LINUX
+    *pidfd = syscall(SYS_pidfd_open, pid_t(pid), 0);
+    if (*pidfd == -1 && errno == ESRCH) {
+        return ESRCH;
+    }
+    // otherwise, e.g. without pidfd support or out of fds, kill() is
+    // used below, guarded by the start time check only
+#else
+    *pidfd = -1;
+#endif
+
+    // with a pidfd the process can not go away and be replaced anymore, so
+    // checking the start time once is enough
+    if (startTime && ProcStat::startTime(pid) != startTime) {
+        if (*pidfd != -1) {
+            close(*pidfd);
+            *pidfd = -1;
+        }
+        return ESRCH;
+    }
+
+#ifdef Q_OS_LINUX
+    if (*pidfd != -1) {
+        return syscall(SYS_pidfd_send_signal, *pidfd, signal, 0, 0) == -1 ? errno : 0;
+    }
+#endif
+
+    return kill(pid_t(pid), signal) == -1 ? errno : 0;
+}
+
+KAuth::ExecuteJob *ProcessTerminator::sendSignalAsRoot(const QVariantList &pids, int signal)
+{
+    KAuth::Action killAction("org.kde.ksysguard.processlisthelper.sendsignal");
+    killAction.setHelperId("org.kde.ksysguard.processlisthelper");
+    for (int i = 0; i < pids.count(); ++i) {
+        killAction.addArgument(QString("pid%1").arg(i), pids[i]);
+    }
+    killAction.addArgument("pidcount", pids.count());
+    killAction.addArgument("signal", signal);
+    return killAction.execute();
+}
+
+void ProcessTerminator::watch(int pidfd, quint64 pid, bool privileged)
+{
+    Watch watch;
+    watch.pid = pid;
+    watch.privileged = privileged;
+    watch.escalated = m_gracePeriod <= 0;
+    watch.notifier = new QSocketNotifier(pidfd, QSocketNotifier::Read, this);
+    watch.started.start();
+    connect(watch.notifier, SIGNAL(activated(int)), this, SLOT(processExited(int)));
+    m_watches.insert(pidfd, watch);
+
+    if (!watch.escalated && !m_escalationTimer->isActive()) {
+        scheduleEscalation();
+    }
+}
+
+void ProcessTerminator::processExited(int pidfd)
+{
+    // a pidfd becomes readable once its process has terminated
+    if (m_watches.contains(pidfd)) {
+        emit terminated(forget(pidfd));
+    }
+}
+
+void ProcessTerminator::escalate()
+{
+    QVariantList privileged;
+    QHash<int, quint64> privilegedFds;
+    QList<int> gone;
+    QList<int> unkillable;
+    for (auto it = m_watches.begin(); it != m_watches.end(); ++it) {
+        Watch &watch = it.value();
+        if (watch.escalated || !watch.started.hasExpired(m_gracePeriod)) {
+            continue;
+        }
+
+        watch.escalated = true;
+        if (watch.privileged) {
+            privileged << watch.pid;
+            privilegedFds.insert(it.key(), watch.pid);
+        } else {
+#ifdef Q_OS_LINUX
+            if (syscall(SYS_pidfd_send_signal, it.key(), SIGKILL, 0, 0) == -1) {
+                if (errno == ESRCH) {
+                    gone << it.key();
+                } else if (errno == EPERM) {
+                    unkillable << it.key();
+                }
+            }
+#endif
+        }
+    }
+
+    foreach (int pidfd, gone) {
+        emit terminated(forget(pidfd));
+    }
+
+    foreach (int pidfd, unkillable) {
+        forget(pidfd);
+    }
+
+    if (!privileged.isEmpty()) {
+        // if the kill is refused there is nothing left to wait for
+        KAuth::ExecuteJob *job = sendSignalAsRoot(privileged, SIGKILL);
+        connect(job, &KJob::finished, this,
+                [this, job, privilegedFds]() {
+                    if (!job->error()) {
+                        return;
+                    }
+
+                    for (auto it = privilegedFds.constBegin(); it != privilegedFds.constEnd(); ++it) {
+                        if (m_watches.contains(it.key()) && m_watches[it.key()].pid == it.value()) {
+                            forget(it.key());
+                        }
+                    }
+                });
+        job->start();
+    }
+
+    scheduleEscalation();
+}
+
+quint64 ProcessTerminator::forget(int pidfd)
+{
+    auto it = m_watches.find(pidfd);
+    if (it == m_watches.end()) {
+        return 0;
+    }
+
+    const Watch watch = it.value();
+    m_watches.erase(it);
+    watch.notifier->setEnabled(false);
+    watch.notifier->deleteLater();
+    close(pidfd);
+    return watch.pid;
+}
+
+void ProcessTerminator::scheduleEscalation()
+{
+    qint64 next = -1;
+    foreach (const Watch &watch, m_watches) {
+        if (!watch.escalated) {
+            const qint64 remaining = qMax(qint64(0), m_gracePeriod - watch.started.elapsed());
+            next = next == -1 ? remaining : qMin(next, remaining);
+        }
+    }
+
+    if (next != -1) {
+        m_escalationTimer->start(next);
+    }
+}
+
+#include "moc_processterminator.cpp"
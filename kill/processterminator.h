@@ -0,0 +1,116 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROCESSTERMINATOR_H
+#define PROCESSTERMINATOR_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QVariantList>
+
+class QSocketNotifier;
+class QTimer;
+
+namespace KAuth
+{
+    class ExecuteJob;
+}
+
+/**
+ * Sends signals through pidfds, so a pid that was reused since it was
+ * matched is never hit, and follows the processes until they are gone.
+ *
+ * Processes that are still alive once the grace period is over get a
+ * SIGKILL. The grace period is read from the GracePeriod entry (in
+ * milliseconds) of the Kill group in sprinterrc; 0 sends SIGKILL right away.
+ *
+ * Watching happens in the thread the terminator lives in, which must run an
+ * event loop.
+ */
+class ProcessTerminator : public QObject
+{
+    Q_OBJECT
+
+public:
+    ProcessTerminator(QObject *parent = 0);
+    ~ProcessTerminator();
+
+    int gracePeriod() const;
+
+    /**
+     * @return the signal to start terminating processes with
+     */
+    int initialSignal() const;
+
+    /**
+     * Sends @p signal to @p pid, provided it is still the process that
+     * started at @p startTime; a start time of 0 skips that check.
+     * @param pidfd set to a pidfd for the process, or -1 if none could be
+     * opened or the process is gone; the caller owns it
+     * @return 0 on success, EPERM if the signal needs privileges, or ESRCH
+     * if the process is gone
+     */
+    static int sendSignal(quint64 pid, quint64 startTime, int signal, int *pidfd);
+
+    /**
+     * Sends @p signal to all @p pids through the KSysGuard helper, with a
+     * single authorization
+     */
+    static KAuth::ExecuteJob *sendSignalAsRoot(const QVariantList &pids, int signal);
+
+public Q_SLOTS:
+    /**
+     * Follows the process behind @p pidfd, and takes ownership of it
+     * @param privileged true if signals to the process need privileges;
+     * only watch such processes once they were signalled successfully, as
+     * escalating asks for authorization again
+     */
+    void watch(int pidfd, quint64 pid, bool privileged);
+
+Q_SIGNALS:
+    void terminated(quint64 pid);
+
+private Q_SLOTS:
+    void processExited(int pidfd);
+    void escalate();
+
+private:
+    struct Watch
+    {
+        quint64 pid;
+        bool privileged;
+        bool escalated;
+        QSocketNotifier *notifier;
+        QElapsedTimer started;
+    };
+
+    /**
+     * Stops following the process behind @p pidfd and closes it
+     * @return the pid of the process, or 0 if @p pidfd was not watched
+     */
+    quint64 forget(int pidfd);
+    void scheduleEscalation();
+
+    int m_gracePeriod;
+    QTimer *m_escalationTimer;
+    QHash<int, Watch> m_watches;
+};
+
+#endif
@@ -0,0 +1,196 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "procscanner.h"
+#include "procstat.h"
+
+#include <QString>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+ProcScanner::ProcScanner()
+    : m_proc(0),
+      m_clockTicks(sysconf(_SC_CLK_TCK)),
+      m_pageSize(sysconf(_SC_PAGESIZE))
+{
+    const int fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd != -1) {
+        m_proc = fdopendir(fd);
+        if (!m_proc) {
+            close(fd);
+        }
+    }
+
+    m_buffer.resize(4096);
+}
+
+ProcScanner::~ProcScanner()
+{
+    if (m_proc) {
+        closedir(m_proc);
+    }
+}
+
+void ProcScanner::scan(QVector<ProcessInfo> &processes)
+{
+    if (!m_proc) {
+        return;
+    }
+
+    QHash<quint64, ProcessInfo> current;
+    current.reserve(m_previous.count());
+    processes.reserve(m_previous.count());
+
+    qint64 elapsed = 0;
+    if (m_lastScan.isValid()) {
+        elapsed = m_lastScan.restart();
+    } else {
+        m_lastScan.start();
+    }
+
+    rewinddir(m_proc);
+    while (dirent *entry = readdir(m_proc)) {
+        if (entry->d_name[0] < '1' || entry->d_name[0] > '9') {
+            continue;
+        }
+
+        char *end;
+        const quint64 pid = strtoull(entry->d_name, &end, 10);
+        if (*end) {
+            continue;
+        }
+
+        auto previous = m_previous.constFind(pid);
+        ProcessInfo info;
+        if (readProcess(pid, previous == m_previous.constEnd() ? 0 : &*previous, elapsed, info)) {
+            current.insert(pid, info);
+            processes << info;
+        }
+    }
+
+    m_previous.swap(current);
+}
+
+bool ProcScanner::readProcess(quint64 pid, const ProcessInfo *previous, qint64 elapsed, ProcessInfo &info)
+{
+    char path[32];
+    snprintf(path, sizeof(path), "%llu", (unsigned long long)pid);
+    const int dirFd = openat(dirfd(m_proc), path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd == -1) {
+        return false;
+    }
+
+    int length = readFile(dirFd, "stat");
+    const ProcStat stat(m_buffer.constData(), length);
+    if (!stat.isValid()) {
+        close(dirFd);
+        return false;
+    }
+
+    const quint64 cpuTime = stat.number(ProcStat::UserTimeField) + stat.number(ProcStat::SystemTimeField);
+    const quint64 startTime = stat.number(ProcStat::StartTimeField);
+    const qint64 rss = stat.number(ProcStat::RssField) * m_pageSize;
+
+    // the name in stat is the comm, which exec() changes; the process is
+    // then read in full again, for its new command line and executable
+    const QString name = QString::fromLocal8Bit(stat.name(), stat.nameLength());
+    if (previous && previous->startTime == startTime && previous->name == name) {
+        // a process we know already; only its resource usage changes
+        info = *previous;
+        info.cpu = elapsed > 0 && m_clockTicks > 0
+                   ? (cpuTime - previous->cpuTime) * 100.0 * 1000 / (m_clockTicks * elapsed) : 0;
+        info.cpuTime = cpuTime;
+        info.rss = rss;
+        close(dirFd);
+        return true;
+    }
+
+    info.pid = pid;
+    info.uid = -1;
+    info.startTime = startTime;
+    info.cpuTime = cpuTime;
+    info.cpu = 0;
+    info.rss = rss;
+    info.name = name;
+
+    length = readFile(dirFd, "status");
+    if (length > 0) {
+        const char *uid = strstr(m_buffer.constData(), "\nUid:");
+        if (uid) {
+            info.uid = strtol(uid + 5, 0, 10);
+        }
+    }
+
+    // arguments are separated by nul bytes; kernel threads have none
+    length = readFile(dirFd, "cmdline");
+    if (length > 0) {
+        char *args = m_buffer.data();
+        while (length > 0 && !args[length - 1]) {
+            --length;
+        }
+        for (int i = 0; i < length; ++i) {
+            if (!args[i]) {
+                args[i] = ' ';
+            }
+        }
+        info.command = QString::fromLocal8Bit(args, length);
+    }
+
+    // only readable for our own processes
+    const ssize_t linkLength = readlinkat(dirFd, "exe", m_buffer.data(), m_buffer.size());
+    if (linkLength > 0) {
+        info.executable = QString::fromLocal8Bit(m_buffer.constData(), linkLength);
+    }
+
+    close(dirFd);
+    return info.uid != -1;
+}
+
+int ProcScanner::readFile(int dirFd, const char *name)
+{
+    const int fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+
+    // leaves room for a terminating nul
+    int length = 0;
+    forever {
+        const ssize_t count = read(fd, m_buffer.data() + length, m_buffer.size() - length - 1);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count <= 0) {
+            break;
+        }
+
+        length += count;
+        if (length == m_buffer.size() - 1) {
+            m_buffer.resize(m_buffer.size() * 2);
+        }
+    }
+
+    close(fd);
+    m_buffer.data()[length] = '\0';
+    return length;
+}
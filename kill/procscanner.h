@@ -0,0 +1,69 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROCSCANNER_H
+#define PROCSCANNER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+
+#include <dirent.h>
+
+#include "processtable.h"
+
+/**
+ * Lists processes by reading just the few files in /proc the kill runner
+ * needs: stat, status, cmdline and the exe link. It is a much lighter
+ * alternative to KSysGuard::Processes, which also collects cpu, memory, io
+ * and tree data.
+ *
+ * The scanner remembers the previous scan: of processes it has seen before
+ * only the stat file is read again, to follow their cpu and memory usage,
+ * unless their name changed there, as it does on exec().
+ * All files are opened relative to a /proc directory that is kept open, and
+ * read into the same buffer.
+ */
+class ProcScanner
+{
+public:
+    ProcScanner();
+    ~ProcScanner();
+
+    /**
+     * Fills @p processes with the running processes
+     */
+    void scan(QVector<ProcessInfo> &processes);
+
+private:
+    Q_DISABLE_COPY(ProcScanner)
+
+    bool readProcess(quint64 pid, const ProcessInfo *previous, qint64 elapsed, ProcessInfo &info);
+    int readFile(int dirFd, const char *name);
+
+    DIR *m_proc;
+    const long m_clockTicks;
+    const long m_pageSize;
+    QElapsedTimer m_lastScan;
+    QByteArray m_buffer;
+    QHash<quint64, ProcessInfo> m_previous;
+};
+
+#endif
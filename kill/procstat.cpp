@@ -0,0 +1,94 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "procstat.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+ProcStat::ProcStat(const char *data, int length)
+    : m_name(0),
+      m_nameLength(0)
+{
+    memset(m_fields, 0, sizeof(m_fields));
+
+    const char *nameBegin = length > 0 ? static_cast<const char *>(memchr(data, '(', length)) : 0;
+    const char *nameEnd = length > 0 ? static_cast<const char *>(memrchr(data, ')', length)) : 0;
+    if (!nameBegin || !nameEnd || nameEnd < nameBegin) {
+        return;
+    }
+
+    m_name = nameBegin + 1;
+    m_nameLength = nameEnd - nameBegin - 1;
+
+    // each field is preceded by a single space, starting with the state
+    const char *end = data + length;
+    const char *space = nameEnd + 1;
+    for (int i = 0; i < s_fieldCount && space < end && *space == ' '; ++i) {
+        m_fields[i] = space + 1;
+        space = static_cast<const char *>(memchr(space + 1, ' ', end - space - 1));
+        if (!space) {
+            break;
+        }
+    }
+}
+
+bool ProcStat::isValid() const
+{
+    return m_name;
+}
+
+const char *ProcStat::name() const
+{
+    return m_name;
+}
+
+int ProcStat::nameLength() const
+{
+    return m_nameLength;
+}
+
+quint64 ProcStat::number(Field field) const
+{
+    // the fields are followed by a space or a newline, which ends the number
+    return m_fields[field] ? strtoull(m_fields[field], 0, 10) : 0;
+}
+
+quint64 ProcStat::startTime(quint64 pid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%llu/stat", (unsigned long long)pid);
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return 0;
+    }
+
+    char buffer[1024];
+    const ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (length <= 0) {
+        return 0;
+    }
+
+    buffer[length] = '\0';
+    return ProcStat(buffer, length).number(StartTimeField);
+}
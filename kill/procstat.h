@@ -0,0 +1,76 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROCSTAT_H
+#define PROCSTAT_H
+
+#include <QtGlobal>
+
+/**
+ * Splits the contents of a /proc/[pid]/stat file into its fields.
+ *
+ * The name is in parentheses and may contain anything, spaces and ')'
+ * included, so the fields are counted from the last ')'. They are numbered
+ * from the state field, which is field 0.
+ */
+class ProcStat
+{
+public:
+    enum Field {
+        StateField = 0,
+        UserTimeField = 11,
+        SystemTimeField = 12,
+        StartTimeField = 19,
+        RssField = 21
+    };
+
+    /**
+     * @param data the contents of the file, followed by a nul byte
+     */
+    ProcStat(const char *data, int length);
+
+    bool isValid() const;
+
+    /**
+     * @return the name of the process, without the parentheses
+     */
+    const char *name() const;
+    int nameLength() const;
+
+    /**
+     * @return the value of the numeric field @p field, or 0 if the file
+     * does not have that many fields
+     */
+    quint64 number(Field field) const;
+
+    /**
+     * @return the start time of @p pid in clock ticks after boot, or 0 if
+     * the process does not exist
+     */
+    static quint64 startTime(quint64 pid);
+
+private:
+    static const int s_fieldCount = RssField + 1;
+
+    const char *m_name;
+    int m_nameLength;
+    const char *m_fields[s_fieldCount];
+};
+
+#endif
@@ -0,0 +1,200 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "socketindex.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// the "st" column of /proc/net/tcp for listening sockets
+static const unsigned long s_tcpListen = 0x0A;
+
+// the position of the inode in a line of /proc/net/tcp and friends,
+// counting from the local address
+static const int s_inodeColumn = 8;
+
+/**
+ * Reads the socket table at @p path in blocks, line by line, and collects
+ * the inodes of the sockets bound to @p port
+ */
+static void scanSocketTable(const char *path, bool tcp, quint16 port, QSet<quint64> &inodes)
+{
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return;
+    }
+
+    char buffer[16384];
+    int length = 0;
+    bool header = true;
+    forever {
+        const ssize_t count = read(fd, buffer + length, sizeof(buffer) - length - 1);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count <= 0) {
+            break;
+        }
+
+        length += count;
+        buffer[length] = '\0';
+
+        char *line = buffer;
+        char *end;
+        while ((end = static_cast<char *>(memchr(line, '\n', buffer + length - line)))) {
+            *end = '\0';
+            if (header) {
+                header = false;
+            } else {
+                // "  sl  local_address rem_address   st ... inode"
+                const char *local = strchr(line, ':');
+                local = local ? local + 1 : 0;
+                while (local && *local == ' ') {
+                    ++local;
+                }
+
+                const char *colon = local ? strchr(local, ':') : 0;
+                if (colon && strtoul(colon + 1, 0, 16) == port) {
+                    const char *field = local;
+                    unsigned long state = 0;
+                    for (int i = 0; i < s_inodeColumn && field; ++i) {
+                        field = strchr(field, ' ');
+                        while (field && *field == ' ') {
+                            ++field;
+                        }
+                        if (i == 1 && field) {
+                            state = strtoul(field, 0, 16);
+                        }
+                    }
+
+                    if (field && (!tcp || state == s_tcpListen)) {
+                        inodes.insert(strtoull(field, 0, 10));
+                    }
+                }
+            }
+            line = end + 1;
+        }
+
+        // keep the partial line for the next block
+        length = buffer + length - line;
+        memmove(buffer, line, length);
+        if (length == int(sizeof(buffer)) - 1) {
+            // can not happen with the kernel's fixed width lines
+            length = 0;
+        }
+    }
+
+    close(fd);
+}
+
+SocketIndex::SocketIndex()
+    : m_proc(open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+{
+    m_buffer.resize(64);
+}
+
+SocketIndex::~SocketIndex()
+{
+    if (m_proc != -1) {
+        close(m_proc);
+    }
+}
+
+void SocketIndex::update(const QVector<ProcessInfo> &processes, bool rescan)
+{
+    QHash<quint64, Sockets> sockets;
+    sockets.reserve(processes.count());
+    for (const ProcessInfo &process: processes) {
+        // a pid that was reused belongs to a different process, with
+        // sockets of its own
+        auto it = m_sockets.constFind(process.pid);
+        if (rescan || it == m_sockets.constEnd() || it->startTime != process.startTime) {
+            Sockets read;
+            read.startTime = process.startTime;
+            read.inodes = readSockets(process.pid);
+            sockets.insert(process.pid, read);
+        } else {
+            sockets.insert(process.pid, *it);
+        }
+    }
+
+    m_sockets.swap(sockets);
+}
+
+QHash<quint64, quint64> SocketIndex::owners() const
+{
+    QHash<quint64, quint64> owners;
+    for (auto it = m_sockets.constBegin(); it != m_sockets.constEnd(); ++it) {
+        foreach (quint64 inode, it.value().inodes) {
+            owners.insert(inode, it.key());
+        }
+    }
+
+    return owners;
+}
+
+QSet<quint64> SocketIndex::socketsOnPort(quint16 port)
+{
+    QSet<quint64> inodes;
+    scanSocketTable("/proc/net/tcp", true, port, inodes);
+    scanSocketTable("/proc/net/tcp6", true, port, inodes);
+    scanSocketTable("/proc/net/udp", false, port, inodes);
+    scanSocketTable("/proc/net/udp6", false, port, inodes);
+    return inodes;
+}
+
+QVector<quint64> SocketIndex::readSockets(quint64 pid)
+{
+    QVector<quint64> sockets;
+    if (m_proc == -1) {
+        return sockets;
+    }
+
+    // only readable for our own processes
+    char path[32];
+    snprintf(path, sizeof(path), "%llu/fd", (unsigned long long)pid);
+    const int fd = openat(m_proc, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+        return sockets;
+    }
+
+    DIR *dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        return sockets;
+    }
+
+    // the links read "socket:[inode]"
+    static const char prefix[] = "socket:[";
+    while (dirent *entry = readdir(dir)) {
+        const ssize_t length = readlinkat(fd, entry->d_name, m_buffer.data(), m_buffer.size() - 1);
+        if (length > int(sizeof(prefix)) - 1 &&
+            memcmp(m_buffer.constData(), prefix, sizeof(prefix) - 1) == 0) {
+            m_buffer.data()[length] = '\0';
+            sockets << strtoull(m_buffer.constData() + sizeof(prefix) - 1, 0, 10);
+        }
+    }
+
+    closedir(dir);
+    return sockets;
+}
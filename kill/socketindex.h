@@ -0,0 +1,79 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOCKETINDEX_H
+#define SOCKETINDEX_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+#include "processtable.h"
+
+/**
+ * Knows which process owns which socket, by the socket inodes found in
+ * /proc/[pid]/fd.
+ *
+ * Reading the fds of every process is expensive, so the sockets of a
+ * process are read once, when it first shows up, and kept from then on;
+ * they are told apart by pid and start time, so a reused pid is read anew.
+ * A full rescan is only done on request, e.g. when a socket could not be
+ * found.
+ */
+class SocketIndex
+{
+public:
+    SocketIndex();
+    ~SocketIndex();
+
+    /**
+     * Brings the index in line with @p processes
+     * @param rescan if true, the fds of all processes are read again
+     */
+    void update(const QVector<ProcessInfo> &processes, bool rescan);
+
+    /**
+     * @return the pid owning each socket inode
+     */
+    QHash<quint64, quint64> owners() const;
+
+    /**
+     * @return the inodes of the listening TCP and the bound UDP sockets on
+     * local @p port, over both IPv4 and IPv6
+     */
+    static QSet<quint64> socketsOnPort(quint16 port);
+
+private:
+    Q_DISABLE_COPY(SocketIndex)
+
+    QVector<quint64> readSockets(quint64 pid);
+
+    int m_proc;
+    QByteArray m_buffer;
+    struct Sockets
+    {
+        quint64 startTime;
+        QVector<quint64> inodes;
+    };
+
+    QHash<quint64, Sockets> m_sockets;
+};
+
+#endif
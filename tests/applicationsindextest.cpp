@@ -0,0 +1,188 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <KSycoca>
+
+#include "applications/applicationsindex.h"
+
+static const char s_desktopFile[] =
+    "[Desktop Entry]\n"
+    "Type=Application\n"
+    "Name=Sprinter Index Test\n"
+    "GenericName=Index Tester\n"
+    "Exec=sprinterindextest %u\n"
+    "Keywords=needle;haystack;\n";
+
+class ApplicationsIndexTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void build();
+    void saveAndLoad();
+    void truncated();
+    void damagedHeader();
+    void damagedTables();
+
+private:
+    QByteArray savedIndex();
+    QSharedPointer<const ApplicationsIndex> load(const QByteArray &data);
+
+    QString m_desktopFilePath;
+    QTemporaryDir m_dir;
+};
+
+void ApplicationsIndexTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+
+    const QString applications =
+        QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/applications";
+    QVERIFY(QDir().mkpath(applications));
+    m_desktopFilePath = applications + "/sprinterindextest.desktop";
+    QFile file(m_desktopFilePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(s_desktopFile);
+    file.close();
+
+    KSycoca::self()->ensureCacheValid();
+}
+
+void ApplicationsIndexTest::cleanupTestCase()
+{
+    QFile::remove(m_desktopFilePath);
+}
+
+QByteArray ApplicationsIndexTest::savedIndex()
+{
+    const QString path = m_dir.path() + "/saved.index";
+    if (!ApplicationsIndex::build()->save(path)) {
+        return QByteArray();
+    }
+
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+QSharedPointer<const ApplicationsIndex> ApplicationsIndexTest::load(const QByteArray &data)
+{
+    const QString path = m_dir.path() + "/loaded.index";
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(data) != data.size()) {
+        return QSharedPointer<const ApplicationsIndex>();
+    }
+    file.close();
+
+    return ApplicationsIndex::load(path);
+}
+
+void ApplicationsIndexTest::build()
+{
+    const QSharedPointer<const ApplicationsIndex> index = ApplicationsIndex::build();
+    const int entry = index->indexOf("sprinterindextest.desktop");
+    QVERIFY(entry >= 0);
+    QCOMPARE(index->entry(entry).name, QStringLiteral("Sprinter Index Test"));
+
+    const QString needle = ApplicationsIndex::fold("Needle");
+    QVERIFY(index->candidates(needle).contains(entry));
+    QVERIFY(index->matchingFields(entry, needle) & ApplicationsIndex::KeywordsField);
+    QVERIFY(index->candidates(ApplicationsIndex::fold("Index Test")).contains(entry));
+    QVERIFY(index->prefixMatches(ApplicationsIndex::fold("Sprinter Ind")).contains(entry));
+    QVERIFY(index->exactNameMatches(ApplicationsIndex::fold("Sprinter Index Test")).contains(entry));
+    QVERIFY(index->exactNameMatches(ApplicationsIndex::fold("Sprinter Index")).isEmpty());
+}
+
+void ApplicationsIndexTest::saveAndLoad()
+{
+    const QSharedPointer<const ApplicationsIndex> built = ApplicationsIndex::build();
+    const QByteArray data = savedIndex();
+    QVERIFY(!data.isEmpty());
+
+    const QSharedPointer<const ApplicationsIndex> loaded = load(data);
+    QVERIFY(loaded);
+    QCOMPARE(loaded->count(), built->count());
+
+    const int entry = loaded->indexOf("sprinterindextest.desktop");
+    QVERIFY(entry >= 0);
+    QCOMPARE(loaded->entry(entry).exec, QStringLiteral("sprinterindextest %u"));
+    QCOMPARE(loaded->candidates(ApplicationsIndex::fold("haystack")), QVector<int>() << entry);
+}
+
+void ApplicationsIndexTest::truncated()
+{
+    const QByteArray data = savedIndex();
+    QVERIFY(!data.isEmpty());
+
+    QVERIFY(!load(QByteArray()));
+    QVERIFY(!load(data.left(16)));
+    QVERIFY(!load(data.left(data.size() / 2)));
+    QVERIFY(!load(data.left(data.size() - 1)));
+}
+
+void ApplicationsIndexTest::damagedHeader()
+{
+    const QByteArray data = savedIndex();
+    QVERIFY(!data.isEmpty());
+
+    // the magic, the version and a byte covered by the checksum only
+    for (int i: { 0, 4, 20 }) {
+        QByteArray damaged = data;
+        damaged[i] = damaged[i] ^ 0x5a;
+        QVERIFY2(!load(damaged), qPrintable(QString::number(i)));
+    }
+}
+
+void ApplicationsIndexTest::damagedTables()
+{
+    QByteArray data = savedIndex();
+    QVERIFY(!data.isEmpty());
+
+    // the header is intact, so this loads; the offsets read from the tables
+    // are only checked on access, which must not crash
+    for (int i = data.size() / 2; i < data.size(); ++i) {
+        data[i] = char(0xff);
+    }
+
+    const QSharedPointer<const ApplicationsIndex> index = load(data);
+    QVERIFY(index);
+    for (int i = 0; i < index->count(); ++i) {
+        index->entry(i);
+        index->execId(i);
+        index->matchingFields(i, "a");
+    }
+
+    index->indexOf("sprinterindextest.desktop");
+    index->candidates("test");
+    index->candidates("sprinter");
+    index->prefixMatches("s");
+    index->exactNameMatches("sprinter index test");
+}
+
+QTEST_GUILESS_MAIN(ApplicationsIndexTest)
+
+#include "applicationsindextest.moc"
@@ -0,0 +1,162 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "applications/launchhistory.h"
+
+class LaunchHistoryTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void recordAndReload();
+    void boosts();
+    void unknownFormat();
+    void partialRecord();
+    void compaction();
+
+private:
+    QString m_path;
+    QScopedPointer<QTemporaryDir> m_dir;
+};
+
+void LaunchHistoryTest::init()
+{
+    m_dir.reset(new QTemporaryDir);
+    QVERIFY(m_dir->isValid());
+    m_path = m_dir->path() + "/sprinter/applications.launches";
+}
+
+void LaunchHistoryTest::recordAndReload()
+{
+    {
+        LaunchHistory history(m_path);
+        QVERIFY(history.mostLaunched(10).isEmpty());
+
+        history.recordLaunch("a.desktop");
+        history.recordLaunch("b.desktop");
+        history.recordLaunch("a.desktop");
+        history.recordLaunch("c.desktop");
+        history.recordLaunch("a.desktop");
+        history.recordLaunch("c.desktop");
+        history.recordLaunch(QString());
+
+        QCOMPARE(history.mostLaunched(2), QStringList() << "a.desktop" << "c.desktop");
+    }
+
+    LaunchHistory history(m_path);
+    QCOMPARE(history.mostLaunched(10), QStringList() << "a.desktop" << "c.desktop" << "b.desktop");
+    QCOMPARE(history.mostLaunched(0), QStringList());
+}
+
+void LaunchHistoryTest::boosts()
+{
+    LaunchHistory history(m_path);
+    history.recordLaunch("a.desktop");
+    history.recordLaunch("a.desktop");
+    history.recordLaunch("b.desktop");
+
+    const LaunchHistory::Boosts boosts = history.boosts();
+    QCOMPARE(boosts.count(), 2);
+    QVERIFY(boosts.value("b.desktop") > 0);
+    QVERIFY(boosts.value("a.desktop") > boosts.value("b.desktop"));
+    QVERIFY(boosts.value("a.desktop") < 1);
+}
+
+void LaunchHistoryTest::unknownFormat()
+{
+    QVERIFY(QDir().mkpath(QFileInfo(m_path).absolutePath()));
+    QFile file(m_path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("XXXX\x01\0\0\0garbage after an unknown header", 39);
+    file.close();
+
+    {
+        LaunchHistory history(m_path);
+        QVERIFY(history.mostLaunched(10).isEmpty());
+        history.recordLaunch("a.desktop");
+    }
+
+    // the launches after the replaced log are kept
+    LaunchHistory history(m_path);
+    QCOMPARE(history.mostLaunched(10), QStringList() << "a.desktop");
+}
+
+void LaunchHistoryTest::partialRecord()
+{
+    {
+        LaunchHistory history(m_path);
+        history.recordLaunch("a.desktop");
+        history.recordLaunch("b.desktop");
+    }
+
+    // half of the header of a third record
+    QFile file(m_path);
+    QVERIFY(file.open(QIODevice::Append));
+    file.write("\x01\0\0\0\0\0", 6);
+    file.close();
+
+    {
+        LaunchHistory history(m_path);
+        QCOMPARE(history.boosts().count(), 2);
+        history.recordLaunch("c.desktop");
+        history.recordLaunch("c.desktop");
+        history.recordLaunch("c.desktop");
+    }
+
+    LaunchHistory history(m_path);
+    QCOMPARE(history.mostLaunched(10).first(), QStringLiteral("c.desktop"));
+    QCOMPARE(history.boosts().count(), 3);
+}
+
+void LaunchHistoryTest::compaction()
+{
+    LaunchHistory::Boosts before;
+    {
+        LaunchHistory history(m_path);
+        for (int i = 0; i < 200; ++i) {
+            history.recordLaunch("a.desktop");
+        }
+        history.recordLaunch("b.desktop");
+        before = history.boosts();
+    }
+
+    // the log was rewritten with one record per storage id at least once,
+    // so it is much smaller than a record per launch
+    const QByteArray id("a.desktop");
+    QVERIFY(QFileInfo(m_path).size() < 200 * (14 + id.size()));
+
+    LaunchHistory history(m_path);
+    const LaunchHistory::Boosts after = history.boosts();
+    QCOMPARE(after.count(), 2);
+    // a second may have passed in between
+    QVERIFY(qAbs(after.value("a.desktop") - before.value("a.desktop")) < 0.001);
+    QVERIFY(qAbs(after.value("b.desktop") - before.value("b.desktop")) < 0.001);
+    QCOMPARE(history.mostLaunched(1), QStringList() << "a.desktop");
+}
+
+QTEST_GUILESS_MAIN(LaunchHistoryTest)
+
+#include "launchhistorytest.moc"
@@ -0,0 +1,123 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "kill/processtable.h"
+
+class ProcessSnapshotTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void nameMatches();
+    void commandMatches();
+    void oncePerProcess();
+    void notAcrossFields();
+    void caseFolded();
+
+private:
+    void addProcess(const QString &name, const QString &command, const QString &executable);
+    QVector<int> indexes(const QVector<ProcessSnapshot::Match> &matches) const;
+
+    ProcessSnapshot m_snapshot;
+};
+
+void ProcessSnapshotTest::addProcess(const QString &name, const QString &command, const QString &executable)
+{
+    ProcessInfo process;
+    process.pid = m_snapshot.processes.count() + 1;
+    process.uid = 1000;
+    process.startTime = 0;
+    process.cpuTime = 0;
+    process.cpu = 0;
+    process.rss = 0;
+    process.name = name;
+    process.command = command;
+    process.executable = executable;
+    m_snapshot.processes << process;
+}
+
+QVector<int> ProcessSnapshotTest::indexes(const QVector<ProcessSnapshot::Match> &matches) const
+{
+    QVector<int> result;
+    foreach (const ProcessSnapshot::Match &match, matches) {
+        result << match.index;
+    }
+    return result;
+}
+
+void ProcessSnapshotTest::initTestCase()
+{
+    addProcess("konsole", "/usr/bin/konsole --workdir /home", "/usr/bin/konsole");
+    addProcess("bash", "/bin/bash", "/bin/bash");
+    addProcess("python3", "python3 -m http.server", "/usr/bin/python3.11");
+    addProcess("kworker/0:1", QString(), QString());
+    addProcess("Xorg", "/usr/lib/Xorg :0", "/usr/lib/Xorg");
+    m_snapshot.index();
+}
+
+void ProcessSnapshotTest::nameMatches()
+{
+    const QVector<ProcessSnapshot::Match> matches = m_snapshot.find("kon");
+    QCOMPARE(matches.count(), 1);
+    QCOMPARE(matches[0].index, 0);
+    QVERIFY(matches[0].inName);
+
+    QCOMPARE(indexes(m_snapshot.find("kworker/0")), QVector<int>() << 3);
+}
+
+void ProcessSnapshotTest::commandMatches()
+{
+    const QVector<ProcessSnapshot::Match> matches = m_snapshot.find("http");
+    QCOMPARE(matches.count(), 1);
+    QCOMPARE(matches[0].index, 2);
+    QVERIFY(!matches[0].inName);
+
+    // only the executable has the version
+    QCOMPARE(indexes(m_snapshot.find("python3.11")), QVector<int>() << 2);
+}
+
+void ProcessSnapshotTest::oncePerProcess()
+{
+    // in the name, command line and executable of the first two processes
+    QCOMPARE(indexes(m_snapshot.find("b")), QVector<int>() << 0 << 1 << 2 << 4);
+    QVERIFY(m_snapshot.find("bash")[0].inName);
+}
+
+void ProcessSnapshotTest::notAcrossFields()
+{
+    // the fields, and the processes, are separated by nul bytes
+    QVERIFY(m_snapshot.find("konsole/usr").isEmpty());
+    QVERIFY(m_snapshot.find("/bin/bashpython3").isEmpty());
+    QVERIFY(m_snapshot.find("no such process").isEmpty());
+    QVERIFY(m_snapshot.find(QByteArray()).isEmpty());
+}
+
+void ProcessSnapshotTest::caseFolded()
+{
+    // the term is folded by the caller; the text is folded by index()
+    QCOMPARE(indexes(m_snapshot.find("xorg")), QVector<int>() << 4);
+    QVERIFY(m_snapshot.find("Xorg").isEmpty());
+}
+
+QTEST_GUILESS_MAIN(ProcessSnapshotTest)
+
+#include "processsnapshottest.moc"
@@ -0,0 +1,84 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include <unistd.h>
+
+#include "kill/procscanner.h"
+#include "kill/procstat.h"
+
+class ProcScannerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void ownProcess();
+    void rescan();
+
+private:
+    const ProcessInfo *findOwnProcess(const QVector<ProcessInfo> &processes) const;
+};
+
+const ProcessInfo *ProcScannerTest::findOwnProcess(const QVector<ProcessInfo> &processes) const
+{
+    for (const ProcessInfo &process: processes) {
+        if (process.pid == quint64(getpid())) {
+            return &process;
+        }
+    }
+
+    return 0;
+}
+
+void ProcScannerTest::ownProcess()
+{
+    ProcScanner scanner;
+    QVector<ProcessInfo> processes;
+    scanner.scan(processes);
+
+    const ProcessInfo *process = findOwnProcess(processes);
+    QVERIFY(process);
+    QCOMPARE(process->name, QStringLiteral("procscannertest"));
+    QCOMPARE(process->uid, qlonglong(getuid()));
+    QVERIFY(process->startTime > 0);
+    QCOMPARE(process->startTime, ProcStat::startTime(getpid()));
+    QVERIFY(process->command.contains(QLatin1String("procscannertest")));
+    QVERIFY(process->rss > 0);
+}
+
+void ProcScannerTest::rescan()
+{
+    // the second scan only reads the stat file of known processes
+    ProcScanner scanner;
+    QVector<ProcessInfo> processes;
+    scanner.scan(processes);
+    processes.clear();
+    scanner.scan(processes);
+
+    const ProcessInfo *process = findOwnProcess(processes);
+    QVERIFY(process);
+    QCOMPARE(process->name, QStringLiteral("procscannertest"));
+    QCOMPARE(process->startTime, ProcStat::startTime(getpid()));
+    QVERIFY(process->command.contains(QLatin1String("procscannertest")));
+}
+
+QTEST_GUILESS_MAIN(ProcScannerTest)
+
+#include "procscannertest.moc"
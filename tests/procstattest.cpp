@@ -0,0 +1,84 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFile>
+#include <QStringList>
+#include <QtTest>
+
+#include <unistd.h>
+
+#include "kill/procstat.h"
+
+class ProcStatTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void ownProcess();
+    void nameWithParentheses();
+    void truncated();
+};
+
+void ProcStatTest::ownProcess()
+{
+    QFile file("/proc/self/stat");
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+
+    // parsed the slow way: the fields after the name, starting with the state
+    const QList<QByteArray> fields = data.mid(data.lastIndexOf(')') + 1).simplified().split(' ');
+    QVERIFY(fields.count() > ProcStat::RssField);
+    const quint64 startTime = fields[ProcStat::StartTimeField].toULongLong();
+    QVERIFY(startTime > 0);
+
+    const ProcStat stat(data.constData(), data.size());
+    QVERIFY(stat.isValid());
+    QCOMPARE(QByteArray(stat.name(), stat.nameLength()), QByteArray("procstattest"));
+    QCOMPARE(stat.number(ProcStat::StartTimeField), startTime);
+    QCOMPARE(stat.number(ProcStat::RssField), fields[ProcStat::RssField].toULongLong());
+    QCOMPARE(ProcStat::startTime(getpid()), startTime);
+}
+
+void ProcStatTest::nameWithParentheses()
+{
+    QByteArray data("42 (a) (b c) R 1 42 42 0 -1 4194304 100 0 0 0 7 3 0 0 20 0 1 0 12345 1000 250\n");
+    const ProcStat stat(data.constData(), data.size());
+    QVERIFY(stat.isValid());
+    QCOMPARE(QByteArray(stat.name(), stat.nameLength()), QByteArray("a) (b c"));
+    QCOMPARE(stat.number(ProcStat::UserTimeField), quint64(7));
+    QCOMPARE(stat.number(ProcStat::SystemTimeField), quint64(3));
+    QCOMPARE(stat.number(ProcStat::StartTimeField), quint64(12345));
+    QCOMPARE(stat.number(ProcStat::RssField), quint64(250));
+}
+
+void ProcStatTest::truncated()
+{
+    QByteArray data("42 (a) R 1 42");
+    const ProcStat stat(data.constData(), data.size());
+    QVERIFY(stat.isValid());
+    QCOMPARE(stat.number(ProcStat::StartTimeField), quint64(0));
+
+    data = "42 (a R 1 42";
+    QVERIFY(!ProcStat(data.constData(), data.size()).isValid());
+    QVERIFY(!ProcStat(0, -1).isValid());
+}
+
+QTEST_GUILESS_MAIN(ProcStatTest)
+
+#include "procstattest.moc"
@@ -0,0 +1,143 @@
+/* Copyright 2026  the Sprinter plugins contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "kill/procstat.h"
+#include "kill/socketindex.h"
+
+class SocketIndexTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+    void socketsOnPort();
+    void owners();
+    void cachedByStartTime();
+
+private:
+    int listen(quint16 &port, quint64 &inode) const;
+    QVector<ProcessInfo> ownProcess(quint64 startTime) const;
+
+    int m_socket;
+    quint16 m_port;
+    quint64 m_inode;
+};
+
+int SocketIndexTest::listen(quint16 &port, quint64 &inode) const
+{
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return -1;
+    }
+
+    // any free port on the loopback interface
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    struct stat info;
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1 ||
+        ::listen(fd, 1) == -1 ||
+        getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length) == -1 ||
+        fstat(fd, &info) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    port = ntohs(address.sin_port);
+    inode = info.st_ino;
+    return fd;
+}
+
+QVector<ProcessInfo> SocketIndexTest::ownProcess(quint64 startTime) const
+{
+    ProcessInfo process;
+    process.pid = getpid();
+    process.uid = getuid();
+    process.startTime = startTime;
+    process.cpuTime = 0;
+    process.cpu = 0;
+    process.rss = 0;
+    return QVector<ProcessInfo>() << process;
+}
+
+void SocketIndexTest::init()
+{
+    m_socket = listen(m_port, m_inode);
+    QVERIFY(m_socket != -1);
+}
+
+void SocketIndexTest::cleanup()
+{
+    if (m_socket != -1) {
+        close(m_socket);
+    }
+}
+
+void SocketIndexTest::socketsOnPort()
+{
+    QVERIFY(SocketIndex::socketsOnPort(m_port).contains(m_inode));
+}
+
+void SocketIndexTest::owners()
+{
+    SocketIndex index;
+    index.update(ownProcess(ProcStat::startTime(getpid())), false);
+    QCOMPARE(index.owners().value(m_inode), quint64(getpid()));
+}
+
+void SocketIndexTest::cachedByStartTime()
+{
+    const quint64 startTime = ProcStat::startTime(getpid());
+    SocketIndex index;
+    index.update(ownProcess(startTime), false);
+
+    quint16 port;
+    quint64 inode;
+    const int fd = listen(port, inode);
+    QVERIFY(fd != -1);
+
+    // the fds of a known process are not read again...
+    index.update(ownProcess(startTime), false);
+    QVERIFY(!index.owners().contains(inode));
+
+    // ...unless its pid now belongs to a different process
+    index.update(ownProcess(startTime + 1), false);
+    QCOMPARE(index.owners().value(inode), quint64(getpid()));
+
+    // or a rescan was asked for
+    close(fd);
+    index.update(ownProcess(startTime + 1), true);
+    QVERIFY(!index.owners().contains(inode));
+    QCOMPARE(index.owners().value(m_inode), quint64(getpid()));
+}
+
+QTEST_GUILESS_MAIN(SocketIndexTest)
+
+#include "socketindextest.moc"
@@ -0,0 +1,165 @@
+/***************************************************************************
+ *   Copyright 2026 by the Sprinter plugins contributors                   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include "windows/windowsquery.h"
+
+class WindowsQueryTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void plainTerm();
+    void actions();
+    void actionOnly();
+    void windowKeyword();
+    void windowFields();
+    void windowDesktop();
+    void desktopKeyword();
+
+private:
+    WindowsQueryParser m_parser;
+};
+
+void WindowsQueryTest::plainTerm()
+{
+    WindowsQuery query;
+    m_parser.parse("firefox", 4, query);
+    QCOMPARE(query.term.toString(), QStringLiteral("firefox"));
+    QCOMPARE(query.action, ActivateAction);
+    QVERIFY(!query.windowKeyword);
+    QVERIFY(!query.desktopKeyword);
+}
+
+void WindowsQueryTest::actions()
+{
+    WindowsQuery query;
+    m_parser.parse("firefox close", 4, query);
+    QCOMPARE(query.term.toString(), QStringLiteral("firefox"));
+    QCOMPARE(query.action, CloseAction);
+
+    // the longest action wins, in any case
+    m_parser.parse("konsole MAXIMIZE", 4, query);
+    QCOMPARE(query.term.toString(), QStringLiteral("konsole"));
+    QCOMPARE(query.action, MaximizeAction);
+
+    m_parser.parse("konsole min", 4, query);
+    QCOMPARE(query.term.toString(), QStringLiteral("konsole"));
+    QCOMPARE(query.action, MinimizeAction);
+
+    m_parser.parse("kate keep above", 4, query);
+    QCOMPARE(query.term.toString(), QStringLiteral("kate"));
+    QCOMPARE(query.action, KeepAboveAction);
+
+    // the previous query is not carried over
+    m_parser.parse("kate", 4, query);
+    QCOMPARE(query.action, ActivateAction);
+}
+
+void WindowsQueryTest::actionOnly()
+{
+    // also matched as a window name
+    WindowsQuery query;
+    m_parser.parse("close", 4, query);
+    QCOMPARE(query.term.toString(), QStringLiteral("close"));
+    QCOMPARE(query.action, CloseAction);
+
+    m_parser.parse("shade", 4, query);
+    QCOMPARE(query.term.toString(), QStringLiteral("shade"));
+    QCOMPARE(query.action, ShadeAction);
+}
+
+void WindowsQueryTest::windowKeyword()
+{
+    WindowsQuery query;
+    m_parser.parse("window", 4, query);
+    QVERIFY(query.windowKeyword);
+    QVERIFY(query.windowTest.isEmpty());
+    QVERIFY(query.windowName.isEmpty());
+
+    m_parser.parse("window kate", 4, query);
+    QVERIFY(query.windowKeyword);
+    QCOMPARE(query.windowTest.toString(), QStringLiteral("kate"));
+    QVERIFY(query.windowName.isEmpty());
+
+    m_parser.parse("window kate close", 4, query);
+    QCOMPARE(query.action, CloseAction);
+    QCOMPARE(query.windowTest.toString(), QStringLiteral("kate"));
+}
+
+void WindowsQueryTest::windowFields()
+{
+    WindowsQuery query;
+    m_parser.parse("window class=xterm", 4, query);
+    QVERIFY(query.windowKeyword);
+    QCOMPARE(query.windowClass.toString(), QStringLiteral("xterm"));
+    QVERIFY(query.windowName.isEmpty());
+    QVERIFY(query.windowRole.isEmpty());
+
+    m_parser.parse("window Role=browser notes", 4, query);
+    QCOMPARE(query.windowRole.toString(), QStringLiteral("browser"));
+    QCOMPARE(query.windowName.toString(), QStringLiteral("notes"));
+
+    // a field without a value yet
+    m_parser.parse("window class=", 4, query);
+    QVERIFY(query.windowKeyword);
+    QVERIFY(query.windowClass.isEmpty());
+
+    m_parser.parse("window class=xterm max", 4, query);
+    QCOMPARE(query.action, MaximizeAction);
+    QCOMPARE(query.windowClass.toString(), QStringLiteral("xterm"));
+}
+
+void WindowsQueryTest::windowDesktop()
+{
+    WindowsQuery query;
+    m_parser.parse("window name=notes desktop=2", 4, query);
+    QCOMPARE(query.windowName.toString(), QStringLiteral("notes"));
+    QCOMPARE(query.windowDesktop, 2);
+
+    // there is no such desktop
+    m_parser.parse("window name=notes desktop=2", 1, query);
+    QCOMPARE(query.windowDesktop, -1);
+
+    m_parser.parse("window desktop=two", 4, query);
+    QCOMPARE(query.windowDesktop, -1);
+}
+
+void WindowsQueryTest::desktopKeyword()
+{
+    WindowsQuery query;
+    m_parser.parse("desktop", 4, query);
+    QVERIFY(query.desktopKeyword);
+    QVERIFY(query.allDesktops);
+    QVERIFY(!query.windowKeyword);
+
+    m_parser.parse("desktop 3", 4, query);
+    QVERIFY(query.desktopKeyword);
+    QVERIFY(!query.allDesktops);
+    QCOMPARE(query.desktop, 3);
+
+    m_parser.parse("desktop three", 4, query);
+    QVERIFY(query.desktopKeyword);
+    QCOMPARE(query.desktop, -1);
+}
+
+QTEST_GUILESS_MAIN(WindowsQueryTest)
+
+#include "windowsquerytest.moc"
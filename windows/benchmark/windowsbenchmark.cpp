@@ -0,0 +1,513 @@
+/***************************************************************************
+ *   Copyright 2026 by the Sprinter plugins contributors                   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/*
+ * Measures how long the windows runner takes to answer queries, and how
+ * many X requests it makes doing so, for different numbers of windows.
+ *
+ * A private Xvfb server is started, unless --no-xvfb is given, and a minimal
+ * EWMH window manager stand-in announces a set of synthetic windows on it.
+ * Query traces are then replayed through WindowsRunner::performMatch(); one
+ * untimed pass warms the icon cache, so the latencies are those of matching
+ * against the snapshot alone.
+ */
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <QX11Info>
+
+#include <KWindowSystem>
+
+#include <xcb/xcb.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "windows.h"
+#include "windowtable.h"
+
+extern char **environ;
+
+// someone typing a few queries, one key at a time
+static const char *s_defaultTrace[] = {
+    "k", "ko", "kon", "kons", "konso", "konsol", "konsole",
+    "f", "fi", "fir", "fire", "firef", "firefo", "firefox", "firefox close",
+    "window", "window class=xterm", "window name=notes desktop=2",
+    "desktop", "desktop 3", "e", "mail", "kate keep above", 0
+};
+
+struct WindowSpec
+{
+    QStringList names;
+    QStringList classes;
+    QStringList roles;
+    int desktops;
+};
+
+/**
+ * Just enough of a window manager for KWindowSystem: it advertises itself,
+ * the desktops and the client list, and sets the properties a window
+ * manager would on the windows it creates.
+ */
+class EwmhStandIn
+{
+public:
+    EwmhStandIn(const QByteArray &display, int desktops);
+    ~EwmhStandIn();
+
+    bool isValid() const;
+    void createWindows(int count, const WindowSpec &spec);
+    void destroyWindows();
+
+private:
+    xcb_atom_t atom(const char *name);
+    void setProperty(xcb_window_t window, xcb_atom_t property, xcb_atom_t type,
+                     int format, int length, const void *data);
+    void setString(xcb_window_t window, xcb_atom_t property, xcb_atom_t type, const QByteArray &value);
+    void setCardinal(xcb_window_t window, const char *property, uint32_t value);
+    void setAtoms(xcb_window_t window, const char *property, const char * const *values);
+    void publishClientList();
+    void sync();
+
+    xcb_connection_t *m_connection;
+    xcb_window_t m_root;
+    xcb_window_t m_check;
+    QVector<xcb_window_t> m_windows;
+};
+
+EwmhStandIn::EwmhStandIn(const QByteArray &display, int desktops)
+    : m_connection(xcb_connect(display.constData(), 0)),
+      m_root(XCB_WINDOW_NONE),
+      m_check(XCB_WINDOW_NONE)
+{
+    if (!isValid()) {
+        return;
+    }
+
+    m_root = xcb_setup_roots_iterator(xcb_get_setup(m_connection)).data->root;
+    m_check = xcb_generate_id(m_connection);
+    xcb_create_window(m_connection, XCB_COPY_FROM_PARENT, m_check, m_root, -1, -1, 1, 1, 0,
+                      XCB_WINDOW_CLASS_INPUT_ONLY, XCB_COPY_FROM_PARENT, 0, 0);
+
+    setProperty(m_root, atom("_NET_SUPPORTING_WM_CHECK"), XCB_ATOM_WINDOW, 32, 1, &m_check);
+    setProperty(m_check, atom("_NET_SUPPORTING_WM_CHECK"), XCB_ATOM_WINDOW, 32, 1, &m_check);
+    setString(m_check, atom("_NET_WM_NAME"), atom("UTF8_STRING"), "sprinter-benchmark-wm");
+
+    const char * const supported[] = {
+        "_NET_SUPPORTED", "_NET_SUPPORTING_WM_CHECK", "_NET_CLIENT_LIST", "_NET_CLIENT_LIST_STACKING",
+        "_NET_NUMBER_OF_DESKTOPS", "_NET_CURRENT_DESKTOP", "_NET_DESKTOP_NAMES", "_NET_WM_NAME",
+        "_NET_WM_DESKTOP", "_NET_WM_WINDOW_TYPE", "_NET_WM_WINDOW_TYPE_NORMAL", "_NET_WM_STATE",
+        "_NET_WM_ALLOWED_ACTIONS", 0
+    };
+    setAtoms(m_root, "_NET_SUPPORTED", supported);
+
+    setCardinal(m_root, "_NET_NUMBER_OF_DESKTOPS", desktops);
+    setCardinal(m_root, "_NET_CURRENT_DESKTOP", 0);
+
+    QByteArray names;
+    for (int i = 1; i <= desktops; ++i) {
+        names += "Desktop " + QByteArray::number(i);
+        names += '\0';
+    }
+    setString(m_root, atom("_NET_DESKTOP_NAMES"), atom("UTF8_STRING"), names);
+
+    publishClientList();
+    sync();
+}
+
+EwmhStandIn::~EwmhStandIn()
+{
+    if (isValid()) {
+        destroyWindows();
+        xcb_destroy_window(m_connection, m_check);
+        sync();
+    }
+
+    xcb_disconnect(m_connection);
+}
+
+bool EwmhStandIn::isValid() const
+{
+    return !xcb_connection_has_error(m_connection);
+}
+
+void EwmhStandIn::createWindows(int count, const WindowSpec &spec)
+{
+    const char * const type[] = { "_NET_WM_WINDOW_TYPE_NORMAL", 0 };
+    const char * const actions[] = {
+        "_NET_WM_ACTION_MOVE", "_NET_WM_ACTION_RESIZE", "_NET_WM_ACTION_MINIMIZE",
+        "_NET_WM_ACTION_SHADE", "_NET_WM_ACTION_MAXIMIZE_VERT", "_NET_WM_ACTION_MAXIMIZE_HORZ",
+        "_NET_WM_ACTION_FULLSCREEN", "_NET_WM_ACTION_CHANGE_DESKTOP", "_NET_WM_ACTION_CLOSE", 0
+    };
+    const char * const state[] = { 0 };
+    const uint32_t normalState[] = { 1, XCB_WINDOW_NONE };
+    const xcb_atom_t wmState = atom("WM_STATE");
+    const xcb_atom_t netWmName = atom("_NET_WM_NAME");
+    const xcb_atom_t utf8String = atom("UTF8_STRING");
+    const xcb_atom_t role = atom("WM_WINDOW_ROLE");
+
+    for (int i = 0; i < count; ++i) {
+        const xcb_window_t window = xcb_generate_id(m_connection);
+        xcb_create_window(m_connection, XCB_COPY_FROM_PARENT, window, m_root, 0, 0, 100, 100, 0,
+                          XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, 0, 0);
+
+        const QString windowClass = spec.classes[i % spec.classes.count()];
+        const QByteArray name = spec.names[i % spec.names.count()].arg(windowClass).arg(i).toUtf8();
+        const QByteArray instance = windowClass.toLower().toLatin1();
+        setString(window, netWmName, utf8String, name);
+        setString(window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, name);
+        setString(window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING,
+                  instance + '\0' + windowClass.toLatin1() + '\0');
+        setString(window, role, XCB_ATOM_STRING, spec.roles[i % spec.roles.count()].toLatin1());
+        setAtoms(window, "_NET_WM_WINDOW_TYPE", type);
+        setCardinal(window, "_NET_WM_DESKTOP", i % spec.desktops);
+        setAtoms(window, "_NET_WM_STATE", state);
+        setAtoms(window, "_NET_WM_ALLOWED_ACTIONS", actions);
+        setProperty(window, wmState, wmState, 32, 2, normalState);
+        m_windows << window;
+    }
+
+    publishClientList();
+    sync();
+}
+
+void EwmhStandIn::destroyWindows()
+{
+    foreach (xcb_window_t window, m_windows) {
+        xcb_destroy_window(m_connection, window);
+    }
+
+    m_windows.clear();
+    publishClientList();
+    sync();
+}
+
+xcb_atom_t EwmhStandIn::atom(const char *name)
+{
+    xcb_intern_atom_reply_t *reply =
+        xcb_intern_atom_reply(m_connection, xcb_intern_atom(m_connection, false, strlen(name), name), 0);
+    const xcb_atom_t atom = reply ? reply->atom : XCB_ATOM_NONE;
+    free(reply);
+    return atom;
+}
+
+void EwmhStandIn::setProperty(xcb_window_t window, xcb_atom_t property, xcb_atom_t type,
+                              int format, int length, const void *data)
+{
+    xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, window, property, type, format, length, data);
+}
+
+void EwmhStandIn::setString(xcb_window_t window, xcb_atom_t property, xcb_atom_t type, const QByteArray &value)
+{
+    setProperty(window, property, type, 8, value.size(), value.constData());
+}
+
+void EwmhStandIn::setCardinal(xcb_window_t window, const char *property, uint32_t value)
+{
+    setProperty(window, atom(property), XCB_ATOM_CARDINAL, 32, 1, &value);
+}
+
+void EwmhStandIn::setAtoms(xcb_window_t window, const char *property, const char * const *values)
+{
+    QVector<xcb_atom_t> atoms;
+    for (; *values; ++values) {
+        atoms << atom(*values);
+    }
+
+    setProperty(window, atom(property), XCB_ATOM_ATOM, 32, atoms.count(), atoms.constData());
+}
+
+void EwmhStandIn::publishClientList()
+{
+    setProperty(m_root, atom("_NET_CLIENT_LIST"), XCB_ATOM_WINDOW, 32, m_windows.count(), m_windows.constData());
+    setProperty(m_root, atom("_NET_CLIENT_LIST_STACKING"), XCB_ATOM_WINDOW, 32, m_windows.count(), m_windows.constData());
+}
+
+void EwmhStandIn::sync()
+{
+    free(xcb_get_input_focus_reply(m_connection, xcb_get_input_focus(m_connection), 0));
+}
+
+static void stopXvfb(pid_t pid)
+{
+    kill(pid, SIGTERM);
+    waitpid(pid, 0, 0);
+}
+
+/**
+ * Starts Xvfb on a display of its own choosing and stores that display in
+ * @p display. The server reports the display number over -displayfd once
+ * it accepts connections.
+ *
+ * @return the pid of the server, or -1 if it did not come up
+ */
+static pid_t startXvfb(QByteArray *display)
+{
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+
+    // only the write end may be inherited by the server
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+
+    QByteArray program("Xvfb");
+    QByteArray displayFdArg("-displayfd");
+    QByteArray displayFd = QByteArray::number(fds[1]);
+    QByteArray screenArg("-screen");
+    QByteArray screen("0");
+    QByteArray geometry("1280x1024x24");
+    QByteArray noListen("-nolisten");
+    QByteArray tcp("tcp");
+    char *argv[] = { program.data(), displayFdArg.data(), displayFd.data(), screenArg.data(), screen.data(),
+                     geometry.data(), noListen.data(), tcp.data(), 0 };
+
+    pid_t pid;
+    const bool spawned = posix_spawnp(&pid, "Xvfb", 0, 0, argv, environ) == 0;
+    close(fds[1]);
+    if (!spawned) {
+        close(fds[0]);
+        return -1;
+    }
+
+    // the server writes the display number followed by a newline
+    QByteArray number;
+    pollfd readable = { fds[0], POLLIN, 0 };
+    while (!number.endsWith('\n') && poll(&readable, 1, 10000) == 1) {
+        char buffer[16];
+        const ssize_t length = read(fds[0], buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+        number.append(buffer, length);
+    }
+    close(fds[0]);
+
+    bool ok = false;
+    const int displayNumber = number.trimmed().toInt(&ok);
+    const QByteArray socket = "/tmp/.X11-unix/X" + QByteArray::number(displayNumber);
+    if (!number.endsWith('\n') || !ok || access(socket.constData(), F_OK) != 0) {
+        stopXvfb(pid);
+        return -1;
+    }
+
+    *display = ':' + QByteArray::number(displayNumber);
+    return pid;
+}
+
+// the sequence number the next request will get
+static unsigned int nextSequence(xcb_connection_t *connection)
+{
+    return xcb_no_operation(connection).sequence + 1;
+}
+
+static qint64 percentile(QVector<qint64> sorted, int p)
+{
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+
+    return sorted[qMin(sorted.count() - 1, (sorted.count() * p) / 100)];
+}
+
+static QStringList readLines(const QString &path)
+{
+    QStringList lines;
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) {
+        QTextStream stream(&file);
+        while (!stream.atEnd()) {
+            const QString line = stream.readLine();
+            if (!line.isEmpty()) {
+                lines << line;
+            }
+        }
+    }
+
+    return lines;
+}
+
+int main(int argc, char **argv)
+{
+    QStringList arguments;
+    for (int i = 0; i < argc; ++i) {
+        arguments << QString::fromLocal8Bit(argv[i]);
+    }
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the latency of the windows runner");
+    parser.addHelpOption();
+    QCommandLineOption sizesOption("sizes", "Comma separated numbers of windows to run with", "list", "10,100,1000");
+    QCommandLineOption iterationsOption("iterations", "How often to replay the trace after the warm-up pass", "count", "20");
+    QCommandLineOption traceOption("trace", "File with one query per line", "file");
+    QCommandLineOption namesOption("names", "File with window name patterns; %1 is the class, %2 the number", "file");
+    QCommandLineOption classesOption("classes", "Comma separated window classes", "list",
+                                     "Konsole,Firefox,Kate,Dolphin,XTerm,Okular,KMail,Amarok");
+    QCommandLineOption rolesOption("roles", "Comma separated window roles", "list", "MainWindow,browser,editor,viewer");
+    QCommandLineOption desktopsOption("desktops", "Number of desktops", "count", "4");
+    QCommandLineOption noXvfbOption("no-xvfb", "Use the display in $DISPLAY instead of starting Xvfb");
+    parser.addOption(sizesOption);
+    parser.addOption(iterationsOption);
+    parser.addOption(traceOption);
+    parser.addOption(namesOption);
+    parser.addOption(classesOption);
+    parser.addOption(rolesOption);
+    parser.addOption(desktopsOption);
+    parser.addOption(noXvfbOption);
+    if (!parser.parse(arguments)) {
+        fprintf(stderr, "%s\n", qPrintable(parser.errorText()));
+        return 1;
+    }
+
+    if (parser.isSet("help")) {
+        printf("%s", qPrintable(parser.helpText()));
+        return 0;
+    }
+
+    QByteArray display = qgetenv("DISPLAY");
+    pid_t xvfb = -1;
+    if (!parser.isSet(noXvfbOption)) {
+        xvfb = startXvfb(&display);
+        if (xvfb == -1) {
+            fprintf(stderr, "could not start Xvfb\n");
+            return 1;
+        }
+        qputenv("DISPLAY", display);
+    }
+    qputenv("QT_QPA_PLATFORM", "xcb");
+
+    int result = 0;
+    {
+        QGuiApplication app(argc, argv);
+
+        WindowSpec spec;
+        spec.names = parser.isSet(namesOption) ? readLines(parser.value(namesOption))
+                                               : QStringList() << "%1 window %2" << "notes %2 - %1" << "mail for page %2";
+        spec.classes = parser.value(classesOption).split(',', QString::SkipEmptyParts);
+        spec.roles = parser.value(rolesOption).split(',', QString::SkipEmptyParts);
+        spec.desktops = qMax(1, parser.value(desktopsOption).toInt());
+
+        QStringList trace;
+        if (parser.isSet(traceOption)) {
+            trace = readLines(parser.value(traceOption));
+        } else {
+            for (int i = 0; s_defaultTrace[i]; ++i) {
+                trace << QString::fromLatin1(s_defaultTrace[i]);
+            }
+        }
+
+        EwmhStandIn standIn(display, spec.desktops);
+        if (!standIn.isValid() || spec.names.isEmpty() || spec.classes.isEmpty() ||
+            spec.roles.isEmpty() || trace.isEmpty()) {
+            fprintf(stderr, "could not set up the benchmark on display %s\n", display.constData());
+            result = 1;
+        } else {
+            // makes KWindowSystem start tracking the client list before it changes
+            KWindowSystem::windows();
+
+            xcb_connection_t *connection = QX11Info::connection();
+            const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+            const QSize imageSize(32, 32);
+            WindowsRunner runner;
+
+            printf("%8s %10s %10s %10s %10s %10s %12s %12s\n", "windows", "load ms", "load reqs",
+                   "p50 us", "p95 us", "p99 us", "reqs/query", "reqs/query");
+            printf("%8s %10s %10s %10s %10s %10s %12s %12s\n", "", "", "",
+                   "", "", "", "(first)", "(repeated)");
+
+            foreach (const QString &size, parser.value(sizesOption).split(',', QString::SkipEmptyParts)) {
+                const int count = size.toInt();
+                standIn.createWindows(count, spec);
+
+                QElapsedTimer wait;
+                wait.start();
+                while (KWindowSystem::windows().count() != count && wait.elapsed() < 5000) {
+                    app.processEvents(QEventLoop::AllEvents, 50);
+                }
+
+                WindowTable table;
+                unsigned int sequence = nextSequence(connection);
+                QElapsedTimer timer;
+                timer.start();
+                table.load();
+                const qint64 loadTime = timer.nsecsElapsed();
+                const unsigned int loadRequests = nextSequence(connection) - sequence - 1;
+
+                const WindowSnapshot snapshot = table.snapshot();
+                QVector<qint64> latencies;
+                quint64 firstRequests = 0;
+                quint64 repeatedRequests = 0;
+                // the first pass fills the icon cache and is not timed; the
+                // timed passes after it do not touch the window system
+                for (int i = 0; i <= iterations; ++i) {
+                    foreach (const QString &query, trace) {
+                        QVector<Sprinter::QueryMatch> matches;
+                        sequence = nextSequence(connection);
+                        timer.restart();
+                        runner.performMatch(snapshot, query, imageSize, 0, matches);
+                        const qint64 latency = timer.nsecsElapsed();
+                        const unsigned int requests = nextSequence(connection) - sequence - 1;
+                        if (i == 0) {
+                            firstRequests += requests;
+                        } else {
+                            latencies << latency;
+                            repeatedRequests += requests;
+                        }
+                    }
+                }
+
+                std::sort(latencies.begin(), latencies.end());
+                printf("%8d %10.2f %10u %10.1f %10.1f %10.1f %12.2f %12.2f\n", count,
+                       loadTime / 1e6, loadRequests,
+                       percentile(latencies, 50) / 1e3,
+                       percentile(latencies, 95) / 1e3,
+                       percentile(latencies, 99) / 1e3,
+                       double(firstRequests) / trace.count(),
+                       double(repeatedRequests) / (trace.count() * iterations));
+                fflush(stdout);
+
+                standIn.destroyWindows();
+                wait.restart();
+                while (!KWindowSystem::windows().isEmpty() && wait.elapsed() < 5000) {
+                    app.processEvents(QEventLoop::AllEvents, 50);
+                }
+            }
+        }
+    }
+
+    if (xvfb != -1) {
+        stopXvfb(xvfb);
+    }
+
+    return result;
+}
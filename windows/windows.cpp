@@ -21,237 +21,305 @@
 #include "windows.h"
 
 #include <QDebug>
+#include <QMutexLocker>
+#include <QTimer>
 #include <QX11Info>
 
 #include <KI18n/KLocalizedString>
 #include <KWindowSystem>
 #include <NETWM>
 
+static const int s_maxIconsCost = 4 * 1024 * 1024;
+
+// changes to windows are sent out at most once per frame
+static const int s_updateInterval = 16;
+
+uint qHash(const WindowIconKey &key)
+{
+    return qHash(quint64(key.id)) ^ uint((key.size.width() << 16) | (key.size.height() & 0xffff));
+}
+
+WindowsSessionData::WindowsSessionData(Sprinter::Runner *runner)
+    : Sprinter::RunnerSessionData(runner),
+      m_table(new WindowTable(this)),
+      m_updateTimer(new QTimer(this))
+{
+    m_updateTimer->setSingleShot(true);
+    m_updateTimer->setInterval(s_updateInterval);
+    connect(m_updateTimer, SIGNAL(timeout()), this, SLOT(sendUpdates()));
+    connect(m_table, SIGNAL(windowUpdated(WId)), this, SLOT(windowUpdated(WId)));
+    connect(m_table, SIGNAL(windowRemoved(WId)), this, SLOT(windowRemoved(WId)));
+    m_table->load();
+}
+
+WindowTable *WindowsSessionData::table() const
+{
+    return m_table;
+}
+
+void WindowsSessionData::setContext(const Sprinter::QueryContext &context)
+{
+    QMutexLocker lock(&m_contextLock);
+    m_context = context;
+}
+
+void WindowsSessionData::windowUpdated(WId id)
+{
+    m_updated.insert(id);
+    if (!m_updateTimer->isActive()) {
+        m_updateTimer->start();
+    }
+}
+
+void WindowsSessionData::windowRemoved(WId id)
+{
+    m_updated.remove(id);
+    m_removed.insert(id);
+    if (!m_updateTimer->isActive()) {
+        m_updateTimer->start();
+    }
+}
+
+void WindowsSessionData::sendUpdates()
+{
+    const QSet<WId> updated = m_updated;
+    const QSet<WId> removed = m_removed;
+    m_updated.clear();
+    m_removed.clear();
+
+    WindowsRunner *wr = qobject_cast<WindowsRunner *>(runner());
+    QMutexLocker lock(&m_contextLock);
+    const Sprinter::QueryContext context = m_context;
+    lock.unlock();
+
+    if (!wr || !context.isValid(this)) {
+        return;
+    }
+
+    const WindowSnapshot snapshot = m_table->snapshot();
+    QHash<WId, int> rows;
+    for (int i = 0; i < snapshot.windows.count(); ++i) {
+        if (updated.contains(snapshot.windows[i].id)) {
+            rows.insert(snapshot.windows[i].id, i);
+        }
+    }
+
+    QVector<Sprinter::QueryMatch> updates;
+    foreach (Sprinter::QueryMatch match, matches(SynchronizedMatches)) {
+        WindowAction action;
+        WId id;
+        if (match.type() != Sprinter::QuerySession::WindowType ||
+            !WindowsRunner::parseMatchData(match.data(), &action, &id)) {
+            continue;
+        }
+
+        if (removed.contains(id)) {
+            // a closed window no longer matches anything
+            match.setPrecision(Sprinter::QuerySession::UnrelatedMatch);
+            updates << match;
+            continue;
+        }
+
+        auto row = rows.constFind(id);
+        if (row != rows.constEnd()) {
+            updates << wr->createWindowMatch(snapshot, snapshot.windows[*row], action,
+                                             match.precision(), context.imageSize());
+        }
+    }
+
+    if (!updates.isEmpty()) {
+        updateMatches(updates);
+    }
+}
+
 WindowsRunner::WindowsRunner(QObject* parent)
     : Sprinter::Runner(parent),
-      m_desktopIcon(QIcon::fromTheme("user-desktop"))
+      m_desktopIcon(QIcon::fromTheme("user-desktop")),
+      m_icons(s_maxIconsCost)
 {
+    connect(KWindowSystem::self(), SIGNAL(windowChanged(WId,const ulong*)),
+            this, SLOT(windowChanged(WId,const ulong*)));
+    connect(KWindowSystem::self(), SIGNAL(windowRemoved(WId)),
+            this, SLOT(forgetIcons(WId)));
 }
 
 WindowsRunner::~WindowsRunner()
 {
 }
 
-template<typename Func>
-void WindowsRunner::forEachWindow(Func algorithm) const
+Sprinter::RunnerSessionData *WindowsRunner::createSessionData()
 {
-    for (auto w: KWindowSystem::windows()) {
-        KWindowInfo info = KWindowInfo(w, NET::WMWindowType | NET::WMDesktop |
-                                       NET::WMState | NET::XAWMState |
-                                       NET::WMName,
-                                       NET::WM2WindowClass | NET::WM2WindowRole |
-                                       NET::WM2AllowedActions);
-        if (info.valid()) {
-            // ignore NET::Tool and other special window types
-            NET::WindowType wType = info.windowType(NET::NormalMask | NET::DesktopMask |
-                                                    NET::DockMask |
-                                                    NET::ToolbarMask | NET::MenuMask |
-                                                    NET::DialogMask |
-                                                    NET::OverrideMask | NET::TopMenuMask |
-                                                    NET::UtilityMask | NET::SplashMask);
-
-            if (wType != NET::Normal && wType != NET::Override && wType != NET::Unknown &&
-                wType != NET::Dialog && wType != NET::Utility) {
-                continue;
-            }
+    return new WindowsSessionData(this);
+}
 
-            algorithm(info);
+template<typename Func>
+void WindowsRunner::forEachWindow(const WindowSnapshot &snapshot, Func algorithm) const
+{
+    foreach (const WindowData &window, snapshot.windows) {
+        // ignore NET::Tool and other special window types
+        const NET::WindowType wType = window.type;
+        if (wType != NET::Normal && wType != NET::Override && wType != NET::Unknown &&
+            wType != NET::Dialog && wType != NET::Utility) {
+            continue;
         }
+
+        algorithm(window);
     }
 }
 
 void WindowsRunner::match(Sprinter::MatchData &matchData)
 {
-    QString term = matchData.queryContext().query();
-
-    // check if the search term ends with an action keyword
-    WindowAction action = ActivateAction;
-    if (term.endsWith(i18n("activate") , Qt::CaseInsensitive)) {
-        action = ActivateAction;
-        term = term.left(term.lastIndexOf(i18n("activate")) - 1);
-    } else if (term.endsWith(i18n("close") , Qt::CaseInsensitive)) {
-        action = CloseAction;
-        term = term.left(term.lastIndexOf(i18n("close")) - 1);
-    } else if (term.endsWith(i18n("min") , Qt::CaseInsensitive)) {
-        action = MinimizeAction;
-        term = term.left(term.lastIndexOf(i18n("min")) - 1);
-    } else if (term.endsWith(i18n("minimize") , Qt::CaseInsensitive)) {
-        action = MinimizeAction;
-        term = term.left(term.lastIndexOf(i18n("minimize")) - 1);
-    } else if (term.endsWith(i18n("max") , Qt::CaseInsensitive)) {
-        action = MaximizeAction;
-        term = term.left(term.lastIndexOf(i18n("max")) - 1);
-    } else if (term.endsWith(i18n("maximize") , Qt::CaseInsensitive)) {
-        action = MaximizeAction;
-        term = term.left(term.lastIndexOf(i18n("maximize")) - 1);
-    } else if (term.endsWith(i18n("fullscreen") , Qt::CaseInsensitive)) {
-        action = FullscreenAction;
-        term = term.left(term.lastIndexOf(i18n("fullscreen")) - 1);
-    } else if (term.endsWith(i18n("shade") , Qt::CaseInsensitive)) {
-        action = ShadeAction;
-        term = term.left(term.lastIndexOf(i18n("shade")) - 1);
-    } else if (term.endsWith(i18n("keep above") , Qt::CaseInsensitive)) {
-        action = KeepAboveAction;
-        term = term.left(term.lastIndexOf(i18n("keep above")) - 1);
-    } else if (term.endsWith(i18n("keep below") , Qt::CaseInsensitive)) {
-        action = KeepBelowAction;
-        term = term.left(term.lastIndexOf(i18n("keep below")) - 1);
+    WindowsSessionData *sessionData = qobject_cast<WindowsSessionData *>(matchData.sessionData());
+    if (!sessionData) {
+        return;
     }
 
-    // keyword match: when term starts with "window" we list all windows
-    // the list can be restricted to windows matching a given name, class, role or desktop
-    if (term.startsWith(i18n("window") , Qt::CaseInsensitive)) {
-        const QStringList keywords = term.split(" ");
-        QString windowName;
-        QString windowClass;
-        QString windowRole;
-        int desktop = -1;
-        bool found = false;
-
-        foreach (const QString& keyword, keywords) {
-            if (keyword.endsWith('=')) {
-                continue;
-            }
-            if (keyword.startsWith(i18n("name") + "=" , Qt::CaseInsensitive)) {
-                windowName = keyword.split("=")[1];
-            } else if (keyword.startsWith(i18n("class") + "=" , Qt::CaseInsensitive)) {
-                windowClass = keyword.split("=")[1];
-            } else if (keyword.startsWith(i18n("role") + "=" , Qt::CaseInsensitive)) {
-                windowRole = keyword.split("=")[1];
-            } else if (keyword.startsWith(i18n("desktop") + "=" , Qt::CaseInsensitive)) {
-                bool ok;
-                desktop = keyword.split("=")[1].toInt(&ok);
-                if (!ok || desktop > KWindowSystem::numberOfDesktops()) {
-                    desktop = -1; // sanity check
-                }
-            } else {
-                // not a keyword - use as name if name is unused, but another option is set
-                if (windowName.isEmpty() && !keyword.contains('=') &&
-                    (!windowRole.isEmpty() || !windowClass.isEmpty() || desktop != -1)) {
-                    windowName = keyword;
-                }
-            }
+    const Sprinter::QueryContext context = matchData.queryContext();
+    sessionData->setContext(context);
+
+    QVector<Sprinter::QueryMatch> matches;
+    performMatch(sessionData->table()->snapshot(), context.query(),
+                 context.imageSize(), &context, matches);
+    foreach (const Sprinter::QueryMatch &match, matches) {
+        matchData << match;
+    }
+}
+
+void WindowsRunner::performMatch(const WindowSnapshot &snapshot, const QString &query,
+                                 const QSize &imageSize, const Sprinter::QueryContext *context,
+                                 QVector<Sprinter::QueryMatch> &matches)
+{
+    // window data comes from the snapshot; the window system is only
+    // consulted for icons that are not cached yet
+    WindowsQuery parsed;
+    m_parser.parse(query, snapshot.numberOfDesktops(), parsed);
+
+    const QStringRef &term = parsed.term;
+    const WindowAction action = parsed.action;
+    const QStringRef &windowName = parsed.windowName;
+    const QStringRef &windowClass = parsed.windowClass;
+    const QStringRef &windowRole = parsed.windowRole;
+    const QStringRef &windowTest = parsed.windowTest;
+    const int windowDesktop = parsed.windowDesktop;
+
+    auto matchesKeywords = [&](const WindowData &window) -> bool {
+        QString windowClassCompare = window.className + " " + window.classClass;
+        // exclude not matching windows
+        if (!windowName.isEmpty() && !window.name.contains(windowName, Qt::CaseInsensitive)) {
+            return false;
         }
 
+        if (!windowClass.isEmpty() && !windowClassCompare.contains(windowClass, Qt::CaseInsensitive)) {
+            return false;
+        }
 
-        auto matchWindow = [&](const KWindowInfo &info) {
-            QString windowClassCompare = QString::fromUtf8(info.windowClassName()) + " " +
-                                         QString::fromUtf8(info.windowClassClass());
-            // exclude not matching windows
-            if (!windowName.isEmpty() && !info.name().contains(windowName, Qt::CaseInsensitive)) {
-                return;
-            }
+        if (!windowRole.isEmpty() && !window.role.contains(windowRole, Qt::CaseInsensitive)) {
+            return false;
+        }
 
-            if (!windowClass.isEmpty() && !windowClassCompare.contains(windowClass, Qt::CaseInsensitive)) {
-                return;
-            }
+        if (windowDesktop != -1 && !window.isOnDesktop(windowDesktop)) {
+            return false;
+        }
 
-            if (!windowRole.isEmpty() && !QString::fromUtf8(info.windowRole()).contains(windowRole, Qt::CaseInsensitive)) {
-                return;
-            }
+        if (windowName.isEmpty() && windowClass.isEmpty() && windowRole.isEmpty() && windowDesktop == -1 &&
+            !window.name.contains(windowTest, Qt::CaseInsensitive) &&
+            !windowClassCompare.contains(windowTest, Qt::CaseInsensitive) &&
+            !window.role.contains(windowTest, Qt::CaseInsensitive)) {
+            return false;
+        }
 
-            if (desktop != -1 && !info.isOnDesktop(desktop)) {
-                return;
-            }
+        // blacklisted everything else: we have a match
+        return actionSupported(window, action);
+    };
 
-            // check for windows when no keywords were used
-            // check the name, class and role for containing the query without the keyword
-            if (windowName.isEmpty() && windowClass.isEmpty() && windowRole.isEmpty() && desktop == -1) {
-                const QString& test = term.mid(keywords[0].length() + 1);
-                if (!info.name().contains(test, Qt::CaseInsensitive) &&
-                    !windowClassCompare.contains(test, Qt::CaseInsensitive) &&
-                    !QString::fromUtf8(info.windowRole()).contains(test, Qt::CaseInsensitive)) {
-                    return;
-                }
-            }
+    // the desktops whose name contains the term; windows on them are listed
+    // with less relevance
+    const int desktops = snapshot.numberOfDesktops();
+    QVector<bool> desktopNameMatches(desktops + 1, false);
+    bool anyDesktopNameMatches = false;
+    for (int i = 1; i <= desktops; ++i) {
+        if (snapshot.desktopName(i).contains(term, Qt::CaseInsensitive)) {
+            desktopNameMatches[i] = true;
+            anyDesktopNameMatches = true;
+        }
+    }
 
-            // blacklisted everything else: we have a match
-            if (actionSupported(info, action)){
-                addWindowMatch(info, action,
-                               Sprinter::QuerySession::ExactMatch,
-                               matchData);
-                found = true;
-            }
-        };
+    // one pass over the windows evaluates every matcher; each window ends up
+    // in the results at most once, with the best precision any matcher gave it
+    QVector<const WindowData *> keywordMatches;
+    QVector<QPair<const WindowData *, Sprinter::QuerySession::MatchPrecision> > windowMatches;
+    auto matchWindow = [&](const WindowData &window) {
+        if (parsed.windowKeyword && matchesKeywords(window)) {
+            keywordMatches << &window;
+        }
 
-        forEachWindow(matchWindow);
+        // check if window name or class contains the query
+        const QString &className = window.className;
+        if (window.name.startsWith(term, Qt::CaseInsensitive) ||
+            className.startsWith(term, Qt::CaseInsensitive)) {
+            windowMatches << qMakePair(&window, Sprinter::QuerySession::CloseMatch);
+            return;
+        }
 
-        if (found) {
-            // the window keyword found matches - do not process other syntax possibilities
+        if (!actionSupported(window, action)) {
             return;
         }
+
+        const bool onMatchingDesktop = window.desktop == NET::OnAllDesktops ?
+                                       anyDesktopNameMatches :
+                                       window.desktop > 0 && window.desktop <= desktops &&
+                                       desktopNameMatches[window.desktop];
+        if (onMatchingDesktop ||
+            window.name.contains(term, Qt::CaseInsensitive) ||
+            className.contains(term, Qt::CaseInsensitive)) {
+            windowMatches << qMakePair(&window, Sprinter::QuerySession::FuzzyMatch);
+        }
+    };
+
+    forEachWindow(snapshot, matchWindow);
+
+    if (!keywordMatches.isEmpty()) {
+        // the window keyword found matches - do not process other syntax possibilities
+        foreach (const WindowData *window, keywordMatches) {
+            addWindowMatch(snapshot, *window, action,
+                           Sprinter::QuerySession::ExactMatch,
+                           imageSize, matches);
+        }
+        return;
     }
+
     bool desktopAdded = false;
     // check for desktop keyword
-    if (term.startsWith(i18n("desktop") , Qt::CaseInsensitive)) {
-        const QStringList parts = term.split(" ");
-        if (parts.size() == 1) {
-            // only keyword - list all desktops
-            for (int i=1; i<=KWindowSystem::numberOfDesktops(); i++) {
-                if (i == KWindowSystem::currentDesktop()) {
-                    continue;
-                }
-                addDesktopMatch(i, Sprinter::QuerySession::ExactMatch, matchData);
-                desktopAdded = true;
-            }
-        } else {
-            // keyword + desktop - restrict matches
-            bool isInt;
-            int desktop = term.mid(parts[0].length() + 1).toInt(&isInt);
-            if (isInt && desktop != KWindowSystem::currentDesktop()) {
-                addDesktopMatch(desktop, Sprinter::QuerySession::ExactMatch, matchData);
-                desktopAdded = true;
+    if (parsed.allDesktops) {
+        // only keyword - list all desktops
+        for (int i=1; i<=desktops; i++) {
+            if (i == snapshot.currentDesktop) {
+                continue;
             }
+            addDesktopMatch(snapshot, i, Sprinter::QuerySession::ExactMatch, imageSize, context, matches);
+            desktopAdded = true;
         }
+    } else if (parsed.desktop != -1 && parsed.desktop != snapshot.currentDesktop) {
+        // keyword + desktop - restrict matches
+        addDesktopMatch(snapshot, parsed.desktop, Sprinter::QuerySession::ExactMatch, imageSize, context, matches);
+        desktopAdded = true;
     }
 
-    // check for matches without keywords
-    auto matchWindow = [&](const KWindowInfo &info) {
-        // check if window name, class or role contains the query
-        QString className = QString::fromUtf8(info.windowClassName());
-        if (info.name().startsWith(term, Qt::CaseInsensitive) ||
-            className.startsWith(term, Qt::CaseInsensitive)) {
-            addWindowMatch(info, action,
-                           Sprinter::QuerySession::CloseMatch,
-                           matchData);
-        } else if ((info.name().contains(term, Qt::CaseInsensitive) ||
-                   className.contains(term, Qt::CaseInsensitive)) &&
-            actionSupported(info, action)) {
-            addWindowMatch(info, action,
-                           Sprinter::QuerySession::FuzzyMatch,
-                           matchData);
-        }
-    };
-
-    forEachWindow(matchWindow);
-
-    // check for matching desktops by name
-    for (int i = 1; i <= KWindowSystem::numberOfDesktops(); ++i) {
-        const QString desktopName = KWindowSystem::desktopName(i);
-        if (desktopName.contains(term, Qt::CaseInsensitive)) {
-            // desktop name matches - offer switch to
-            // only add desktops if it hasn't been added by the keyword which is quite likely
-            if (!desktopAdded && i != KWindowSystem::currentDesktop()) {
-                addDesktopMatch(i, Sprinter::QuerySession::CloseMatch, matchData);
+    // desktop name matches - offer switch to
+    // only add desktops if it hasn't been added by the keyword which is quite likely
+    if (!desktopAdded) {
+        for (int i = 1; i <= desktops; ++i) {
+            if (desktopNameMatches[i] && i != snapshot.currentDesktop) {
+                addDesktopMatch(snapshot, i, Sprinter::QuerySession::CloseMatch, imageSize, context, matches);
             }
-
-            // search for windows on desktop and list them with less relevance
-            auto matchWindowsOnDesktop = [&](const KWindowInfo &info) {
-                if (info.isOnDesktop(i) && actionSupported(info, action)) {
-                    addWindowMatch(info, action,
-                                   Sprinter::QuerySession::FuzzyMatch,
-                                   matchData);
-                }
-            };
-
-            forEachWindow(matchWindowsOnDesktop);
         }
     }
+
+    for (int i = 0; i < windowMatches.count(); ++i) {
+        addWindowMatch(snapshot, *windowMatches[i].first, action,
+                       windowMatches[i].second,
+                       imageSize, matches);
+    }
 }
 
 bool WindowsRunner::exec(const Sprinter::QueryMatch& match)
@@ -262,9 +330,13 @@ bool WindowsRunner::exec(const Sprinter::QueryMatch& match)
         return true;
     }
 
-    const QStringList parts = match.data().toString().split("_");
-    WindowAction action = WindowAction(parts[0].toInt());
-    WId w = WId(parts[1].toULong());
+    WindowAction action;
+    WId w;
+    if (!parseMatchData(match.data(), &action, &w) || !KWindowSystem::hasWId(w)) {
+        // the window was closed since the match was made
+        return false;
+    }
+
     KWindowInfo info = KWindowInfo(w, NET::WMState);
     switch (action) {
     case ActivateAction:
@@ -323,43 +395,57 @@ bool WindowsRunner::exec(const Sprinter::QueryMatch& match)
     return true;
 }
 
-void WindowsRunner::addDesktopMatch(int desktop,
+void WindowsRunner::addDesktopMatch(const WindowSnapshot &snapshot, int desktop,
                                     Sprinter::QuerySession::MatchPrecision precision,
-                                    Sprinter::MatchData &matchData)
+                                    const QSize &imageSize,
+                                    const Sprinter::QueryContext *context,
+                                    QVector<Sprinter::QueryMatch> &matches)
 {
     Sprinter::QueryMatch match;
     match.setType(Sprinter::QuerySession::DesktopType);
     match.setSource(Sprinter::QuerySession::FromDesktopShell);
     match.setData(desktop);
-    match.setImage(generateImage(m_desktopIcon, matchData.queryContext()));
-    QString desktopName = KWindowSystem::desktopName(desktop);
+    if (context) {
+        match.setImage(generateImage(m_desktopIcon, *context));
+    } else {
+        match.setImage(m_desktopIcon.pixmap(imageSize).toImage());
+    }
+    QString desktopName = snapshot.desktopName(desktop);
     match.setTitle(desktopName);
     match.setText(i18n("Switch to desktop ").arg(desktop));
     match.setPrecision(precision);
-    matchData << match;
+    matches << match;
 }
 
-void WindowsRunner::addWindowMatch(const KWindowInfo& info,
+void WindowsRunner::addWindowMatch(const WindowSnapshot &snapshot,
+                                   const WindowData &window,
                                    WindowAction action,
                                    Sprinter::QuerySession::MatchPrecision precision,
-                                   Sprinter::MatchData &matchData)
+                                   const QSize &imageSize,
+                                   QVector<Sprinter::QueryMatch> &matches)
+{
+    matches << createWindowMatch(snapshot, window, action, precision, imageSize);
+}
+
+Sprinter::QueryMatch WindowsRunner::createWindowMatch(const WindowSnapshot &snapshot,
+                                                      const WindowData &window,
+                                                      WindowAction action,
+                                                      Sprinter::QuerySession::MatchPrecision precision,
+                                                      const QSize &imageSize)
 {
     Sprinter::QueryMatch match;
     match.setType(Sprinter::QuerySession::WindowType);
     match.setSource(Sprinter::QuerySession::FromDesktopShell);
-    match.setData(QString(QString::number((int)action) + "_" + QString::number(info.win())));
-    const QSize imageSize = matchData.queryContext().imageSize();
-    //TODO: cache the images?
-    QImage icon = KWindowSystem::icon(info.win(), imageSize.width(), imageSize.height()).scaled(imageSize, Qt::KeepAspectRatio, Qt::SmoothTransformation).toImage();
-    match.setImage(icon);
-    match.setTitle(info.name());
-
-    int desktop = info.desktop();
+    match.setData(QString(QString::number((int)action) + "_" + QString::number(window.id)));
+    match.setImage(windowIcon(window.id, imageSize));
+    match.setTitle(window.name);
+
+    int desktop = window.desktop;
     if (desktop == NET::OnAllDesktops) {
-        desktop = KWindowSystem::currentDesktop();
+        desktop = snapshot.currentDesktop;
     }
 
-    QString desktopName = KWindowSystem::desktopName(desktop);
+    QString desktopName = snapshot.desktopName(desktop);
 
     switch (action) {
     case CloseAction:
@@ -389,22 +475,34 @@ void WindowsRunner::addWindowMatch(const KWindowInfo& info,
         break;
     }
     match.setPrecision(precision);
-    matchData << match;
+    return match;
 }
 
-bool WindowsRunner::actionSupported(const KWindowInfo& info, WindowAction action)
+bool WindowsRunner::parseMatchData(const QVariant &data, WindowAction *action, WId *id)
+{
+    const QStringList parts = data.toString().split("_");
+    if (parts.count() != 2) {
+        return false;
+    }
+
+    *action = WindowAction(parts[0].toInt());
+    *id = WId(parts[1].toULong());
+    return true;
+}
+
+bool WindowsRunner::actionSupported(const WindowData &window, WindowAction action)
 {
     switch (action) {
     case CloseAction:
-        return info.actionSupported(NET::ActionClose);
+        return window.actionSupported(NET::ActionClose);
     case MinimizeAction:
-        return info.actionSupported(NET::ActionMinimize);
+        return window.actionSupported(NET::ActionMinimize);
     case MaximizeAction:
-        return info.actionSupported(NET::ActionMax);
+        return window.actionSupported(NET::ActionMax);
     case ShadeAction:
-        return info.actionSupported(NET::ActionShade);
+        return window.actionSupported(NET::ActionShade);
     case FullscreenAction:
-        return info.actionSupported(NET::ActionFullScreen);
+        return window.actionSupported(NET::ActionFullScreen);
     case KeepAboveAction:
     case KeepBelowAction:
     case ActivateAction:
@@ -413,4 +511,39 @@ bool WindowsRunner::actionSupported(const KWindowInfo& info, WindowAction action
     }
 }
 
+QImage WindowsRunner::windowIcon(WId id, const QSize &size)
+{
+    const WindowIconKey key(id, size);
+    QMutexLocker lock(&m_iconsLock);
+    QImage *cached = m_icons.object(key);
+    if (cached) {
+        return *cached;
+    }
+    lock.unlock();
+
+    QImage icon = KWindowSystem::icon(id, size.width(), size.height()).scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation).toImage();
+
+    lock.relock();
+    m_icons.insert(key, new QImage(icon), qMax(icon.byteCount(), 1));
+    return icon;
+}
+
+void WindowsRunner::windowChanged(WId id, const unsigned long *properties)
+{
+    if ((properties[NETWinInfo::PROTOCOLS] & NET::WMIcon) ||
+        (properties[NETWinInfo::PROTOCOLS2] & NET::WM2IconPixmap)) {
+        forgetIcons(id);
+    }
+}
+
+void WindowsRunner::forgetIcons(WId id)
+{
+    QMutexLocker lock(&m_iconsLock);
+    foreach (const WindowIconKey &key, m_icons.keys()) {
+        if (key.id == id) {
+            m_icons.remove(key);
+        }
+    }
+}
+
 #include "moc_windows.cpp"
@@ -22,9 +22,65 @@
 
 #include <Sprinter/Runner>
 
+#include <QCache>
 #include <QIcon>
+#include <QImage>
+#include <QMutex>
+#include <QSet>
+#include <QSize>
 
-class KWindowInfo;
+#include "windowsquery.h"
+#include "windowtable.h"
+
+struct WindowIconKey
+{
+    WindowIconKey(WId w, const QSize &s)
+        : id(w),
+          size(s)
+    {
+    }
+
+    bool operator==(const WindowIconKey &other) const
+    {
+        return id == other.id && size == other.size;
+    }
+
+    WId id;
+    QSize size;
+};
+
+uint qHash(const WindowIconKey &key);
+
+class QTimer;
+
+class WindowsSessionData : public Sprinter::RunnerSessionData
+{
+    Q_OBJECT
+
+public:
+    WindowsSessionData(Sprinter::Runner *runner);
+
+    WindowTable *table() const;
+
+    /**
+     * Remembers the context of the latest query, so the matches shown for
+     * it can be kept up to date as windows change
+     */
+    void setContext(const Sprinter::QueryContext &context);
+
+private Q_SLOTS:
+    void windowUpdated(WId id);
+    void windowRemoved(WId id);
+    void sendUpdates();
+
+private:
+    WindowTable *m_table;
+    QTimer *m_updateTimer;
+    QSet<WId> m_updated;
+    QSet<WId> m_removed;
+    QMutex m_contextLock;
+    Sprinter::QueryContext m_context;
+};
 
 class WindowsRunner : public Sprinter::Runner
 {
@@ -36,38 +92,67 @@ public:
     WindowsRunner(QObject *parent = 0);
     ~WindowsRunner();
 
+    Sprinter::RunnerSessionData *createSessionData();
     virtual void match(Sprinter::MatchData &context);
     virtual bool exec(const Sprinter::QueryMatch &match);
 
+    /**
+     * Matches @p query against the windows and desktops in @p snapshot.
+     * Window data comes from the snapshot; only icons missing from the
+     * icon cache are fetched from the window system.
+     *
+     * @p context is used to render desktop images via generateImage(). It
+     * may be null outside of a query session, in which case the desktop
+     * icon is rendered at @p imageSize directly.
+     */
+    void performMatch(const WindowSnapshot &snapshot, const QString &query,
+                      const QSize &imageSize, const Sprinter::QueryContext *context,
+                      QVector<Sprinter::QueryMatch> &matches);
+
+    /**
+     * @return a match for @p window that performs @p action
+     */
+    Sprinter::QueryMatch createWindowMatch(const WindowSnapshot &snapshot,
+                                           const WindowData &window, WindowAction action,
+                                           Sprinter::QuerySession::MatchPrecision precision,
+                                           const QSize &imageSize);
+
+    /**
+     * Reads the action and window back from the data of a window match
+     */
+    static bool parseMatchData(const QVariant &data, WindowAction *action, WId *id);
+
 private Q_SLOTS:
+    void windowChanged(WId id, const unsigned long *properties);
+    void forgetIcons(WId id);
 //    void prepareForMatchSession();
 //    void matchSessionComplete();
 //    void gatherInfo();
 
 private:
-    enum WindowAction {
-        ActivateAction,
-        CloseAction,
-        MinimizeAction,
-        MaximizeAction,
-        FullscreenAction,
-        ShadeAction,
-        KeepAboveAction,
-        KeepBelowAction
-    };
-
     template<typename Func>
-    void forEachWindow(Func algorithm) const;
+    void forEachWindow(const WindowSnapshot &snapshot, Func algorithm) const;
 
-    void addDesktopMatch(int desktop,
+    void addDesktopMatch(const WindowSnapshot &snapshot, int desktop,
                          Sprinter::QuerySession::MatchPrecision precision,
-                         Sprinter::MatchData &context);
-    void addWindowMatch(const KWindowInfo& info, WindowAction action,
+                         const QSize &imageSize, const Sprinter::QueryContext *context,
+                         QVector<Sprinter::QueryMatch> &matches);
+    void addWindowMatch(const WindowSnapshot &snapshot,
+                        const WindowData &window, WindowAction action,
                         Sprinter::QuerySession::MatchPrecision precision,
-                        Sprinter::MatchData &context);
-    bool actionSupported(const KWindowInfo& info, WindowAction action);
+                        const QSize &imageSize,
+                        QVector<Sprinter::QueryMatch> &matches);
+    bool actionSupported(const WindowData &window, WindowAction action);
+    QImage windowIcon(WId id, const QSize &size);
 
+    WindowsQueryParser m_parser;
     QIcon m_desktopIcon;
+
+    /**
+     * Window icons, scaled, per window and image size; bounded by their size in bytes
+     */
+    QMutex m_iconsLock;
+    QCache<WindowIconKey, QImage> m_icons;
 };
 
 #endif // WINDOWSRUNNER_H
@@ -0,0 +1,231 @@
+/***************************************************************************
+ *   Copyright 2009 by Martin Gräßlin <kde@martin-graesslin.com>           *
+ *   Copyright 2014 by Aaron Seigo <aseigo@kde.org>                        *
+ *   Copyright 2026 by the Sprinter plugins contributors                   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "windowsquery.h"
+
+#include <KI18n/KLocalizedString>
+
+static int indexOf(const QChar *chars, int from, int to, QChar c)
+{
+    for (int i = from; i < to; ++i) {
+        if (chars[i] == c) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+WindowsQuery::WindowsQuery()
+    : action(ActivateAction),
+      windowKeyword(false),
+      windowDesktop(-1),
+      desktopKeyword(false),
+      allDesktops(false),
+      desktop(-1)
+{
+}
+
+WindowsQueryParser::Trie::Node::Node()
+    : value(-1)
+{
+}
+
+WindowsQueryParser::Trie::Trie()
+    : m_nodes(1)
+{
+}
+
+void WindowsQueryParser::Trie::insert(const QString &word, int value, bool reversed)
+{
+    const QString folded = word.toCaseFolded();
+    int node = 0;
+    for (int i = 0; i < folded.length(); ++i) {
+        const ushort c = folded[reversed ? folded.length() - 1 - i : i].unicode();
+        int next = child(node, c);
+        if (next == -1) {
+            next = m_nodes.count();
+            m_nodes[node].edges << qMakePair(c, next);
+            m_nodes << Node();
+        }
+        node = next;
+    }
+
+    m_nodes[node].value = value;
+}
+
+int WindowsQueryParser::Trie::longestMatch(const QChar *chars, int length, int step, int *matched) const
+{
+    int value = -1;
+    *matched = 0;
+    int node = 0;
+    for (int i = 0; i < length; ++i) {
+        node = child(node, chars[i * step].toCaseFolded().unicode());
+        if (node == -1) {
+            break;
+        }
+
+        if (m_nodes[node].value != -1) {
+            value = m_nodes[node].value;
+            *matched = i + 1;
+        }
+    }
+
+    return value;
+}
+
+int WindowsQueryParser::Trie::child(int node, ushort c) const
+{
+    const QVector<QPair<ushort, int> > &edges = m_nodes[node].edges;
+    for (int i = 0; i < edges.count(); ++i) {
+        if (edges[i].first == c) {
+            return edges[i].second;
+        }
+    }
+
+    return -1;
+}
+
+WindowsQueryParser::WindowsQueryParser()
+{
+    // actions are given at the end of the query, so they are matched backwards
+    m_actions.insert(i18n("activate"), ActivateAction, true);
+    m_actions.insert(i18n("close"), CloseAction, true);
+    m_actions.insert(i18n("min"), MinimizeAction, true);
+    m_actions.insert(i18n("minimize"), MinimizeAction, true);
+    m_actions.insert(i18n("max"), MaximizeAction, true);
+    m_actions.insert(i18n("maximize"), MaximizeAction, true);
+    m_actions.insert(i18n("fullscreen"), FullscreenAction, true);
+    m_actions.insert(i18n("shade"), ShadeAction, true);
+    m_actions.insert(i18n("keep above"), KeepAboveAction, true);
+    m_actions.insert(i18n("keep below"), KeepBelowAction, true);
+
+    m_keywords.insert(i18n("window"), WindowKeyword);
+    m_keywords.insert(i18n("desktop"), DesktopKeyword);
+
+    m_fields.insert(i18n("name") + "=", NameField);
+    m_fields.insert(i18n("class") + "=", ClassField);
+    m_fields.insert(i18n("role") + "=", RoleField);
+    m_fields.insert(i18n("desktop") + "=", DesktopField);
+}
+
+void WindowsQueryParser::parse(const QString &query, int numberOfDesktops, WindowsQuery &result) const
+{
+    result = WindowsQuery();
+
+    const QChar *chars = query.constData();
+    int length = query.length();
+    int matched;
+
+    // check if the search term ends with an action keyword; the action and
+    // the character separating it from the rest are dropped, unless the
+    // action is all there is, which is then also matched as a window name
+    const int action = m_actions.longestMatch(chars + length - 1, length, -1, &matched);
+    if (action != -1) {
+        result.action = WindowAction(action);
+        if (matched < length) {
+            length = qMax(0, length - matched - 1);
+        }
+    }
+
+    result.term = QStringRef(&query, 0, length);
+
+    const int keyword = m_keywords.longestMatch(chars, length, 1, &matched);
+    if (keyword == -1) {
+        return;
+    }
+
+    // the first word, keyword included, and what follows it
+    int firstSpace = indexOf(chars, 0, length, ' ');
+    if (firstSpace == -1) {
+        firstSpace = length;
+    }
+
+    const QStringRef rest = firstSpace < length ? QStringRef(&query, firstSpace + 1, length - firstSpace - 1)
+                                                : QStringRef();
+
+    if (keyword == DesktopKeyword) {
+        result.desktopKeyword = true;
+        if (firstSpace == length) {
+            // only keyword - list all desktops
+            result.allDesktops = true;
+        } else {
+            // keyword + desktop - restrict matches
+            bool isInt;
+            const int desktop = rest.toInt(&isInt);
+            result.desktop = isInt ? desktop : -1;
+        }
+        return;
+    }
+
+    // window keyword: the list can be restricted to windows matching a given
+    // name, class, role or desktop
+    result.windowKeyword = true;
+    result.windowTest = rest;
+
+    for (int start = 0; start <= length; ) {
+        int end = indexOf(chars, start, length, ' ');
+        if (end == -1) {
+            end = length;
+        }
+
+        const int equals = indexOf(chars, start, end, '=');
+        if (end > start && chars[end - 1] == '=') {
+            // a field without a value yet
+        } else if (equals != -1) {
+            const int field = m_fields.longestMatch(chars + start, end - start, 1, &matched);
+            if (field != -1 && start + matched == equals + 1) {
+                // the value runs up to the next '=', if any
+                int valueEnd = indexOf(chars, equals + 1, end, '=');
+                if (valueEnd == -1) {
+                    valueEnd = end;
+                }
+
+                const QStringRef value(&query, equals + 1, valueEnd - equals - 1);
+                switch (field) {
+                case NameField:
+                    result.windowName = value;
+                    break;
+                case ClassField:
+                    result.windowClass = value;
+                    break;
+                case RoleField:
+                    result.windowRole = value;
+                    break;
+                case DesktopField: {
+                    bool ok;
+                    result.windowDesktop = value.toInt(&ok);
+                    if (!ok || result.windowDesktop > numberOfDesktops) {
+                        result.windowDesktop = -1; // sanity check
+                    }
+                    break;
+                }
+                }
+            }
+        } else if (result.windowName.isEmpty() &&
+                   (!result.windowRole.isEmpty() || !result.windowClass.isEmpty() || result.windowDesktop != -1)) {
+            // not a keyword - use as name if name is unused, but another option is set
+            result.windowName = QStringRef(&query, start, end - start);
+        }
+
+        start = end + 1;
+    }
+}
@@ -0,0 +1,131 @@
+/***************************************************************************
+ *   Copyright 2009 by Martin Gräßlin <kde@martin-graesslin.com>           *
+ *   Copyright 2014 by Aaron Seigo <aseigo@kde.org>                        *
+ *   Copyright 2026 by the Sprinter plugins contributors                   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+#ifndef WINDOWSQUERY_H
+#define WINDOWSQUERY_H
+
+#include <QPair>
+#include <QString>
+#include <QStringRef>
+#include <QVector>
+
+enum WindowAction {
+    ActivateAction,
+    CloseAction,
+    MinimizeAction,
+    MaximizeAction,
+    FullscreenAction,
+    ShadeAction,
+    KeepAboveAction,
+    KeepBelowAction
+};
+
+/**
+ * A query to the windows runner, taken apart. All strings refer to the
+ * query they were parsed from.
+ */
+struct WindowsQuery
+{
+    WindowsQuery();
+
+    // the action named at the end of the query, ActivateAction if none
+    WindowAction action;
+
+    // the query without the action
+    QStringRef term;
+
+    // "window [name=..] [class=..] [role=..] [desktop=..]"
+    bool windowKeyword;
+    QStringRef windowName;
+    QStringRef windowClass;
+    QStringRef windowRole;
+    int windowDesktop;
+
+    // what follows the window keyword, matched when no field is given
+    QStringRef windowTest;
+
+    // "desktop [number]"
+    bool desktopKeyword;
+    bool allDesktops;
+    int desktop;
+};
+
+/**
+ * Parses queries to the windows runner. The localized vocabulary is looked
+ * up and compiled into tries once, when the parser is created; parsing a
+ * query is then a single scan over it that does not allocate.
+ */
+class WindowsQueryParser
+{
+public:
+    WindowsQueryParser();
+
+    void parse(const QString &query, int numberOfDesktops, WindowsQuery &result) const;
+
+private:
+    /**
+     * Maps case folded words to values. Words are matched case insensitively
+     * either forwards from the start of a string or backwards from its end.
+     */
+    class Trie
+    {
+    public:
+        Trie();
+
+        void insert(const QString &word, int value, bool reversed = false);
+
+        /**
+         * @return the value of the longest word at @p chars, walking
+         * @p length characters in direction @p step, or -1 if none matches
+         */
+        int longestMatch(const QChar *chars, int length, int step, int *matched) const;
+
+    private:
+        struct Node
+        {
+            Node();
+
+            QVector<QPair<ushort, int> > edges;
+            int value;
+        };
+
+        int child(int node, ushort c) const;
+
+        QVector<Node> m_nodes;
+    };
+
+    enum Keyword {
+        WindowKeyword,
+        DesktopKeyword
+    };
+
+    enum Field {
+        NameField,
+        ClassField,
+        RoleField,
+        DesktopField
+    };
+
+    Trie m_actions;
+    Trie m_keywords;
+    Trie m_fields;
+};
+
+#endif
@@ -0,0 +1,258 @@
+/***************************************************************************
+ *   Copyright 2009 by Martin Gräßlin <kde@martin-graesslin.com>           *
+ *   Copyright 2014 by Aaron Seigo <aseigo@kde.org>                        *
+ *   Copyright 2026 by the Sprinter plugins contributors                   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "windowtable.h"
+
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QX11Info>
+
+#include <KWindowInfo>
+#include <KWindowSystem>
+
+#include "xcbwindowloader.h"
+
+static const NET::Properties s_properties = NET::WMWindowType | NET::WMDesktop |
+                                            NET::WMState | NET::XAWMState |
+                                            NET::WMName;
+static const NET::Properties2 s_properties2 = NET::WM2WindowClass | NET::WM2WindowRole |
+                                              NET::WM2AllowedActions;
+
+// windows of any other type are read as NET::Unknown
+static const NET::WindowTypes s_windowTypes = NET::NormalMask | NET::DesktopMask |
+                                              NET::DockMask |
+                                              NET::ToolbarMask | NET::MenuMask |
+                                              NET::DialogMask |
+                                              NET::OverrideMask | NET::TopMenuMask |
+                                              NET::UtilityMask | NET::SplashMask;
+
+WindowData::WindowData()
+    : id(0),
+      desktop(0),
+      type(NET::Unknown),
+      state(0),
+      allowedActions(0),
+      minimized(false)
+{
+}
+
+bool WindowData::isOnDesktop(int d) const
+{
+    return desktop == d || desktop == NET::OnAllDesktops;
+}
+
+bool WindowData::hasState(NET::States s) const
+{
+    return (state & s) == s;
+}
+
+bool WindowData::actionSupported(NET::Action action) const
+{
+    return allowedActions & action;
+}
+
+WindowSnapshot::WindowSnapshot()
+    : currentDesktop(1)
+{
+}
+
+int WindowSnapshot::numberOfDesktops() const
+{
+    return desktopNames.count();
+}
+
+QString WindowSnapshot::desktopName(int desktop) const
+{
+    return desktopNames.value(desktop - 1);
+}
+
+WindowTable::WindowTable(QObject *parent)
+    : QObject(parent)
+{
+    if (QX11Info::isPlatformX11()) {
+        m_loader.reset(new XcbWindowLoader(QX11Info::connection()));
+    }
+
+    connect(KWindowSystem::self(), SIGNAL(windowAdded(WId)),
+            this, SLOT(addWindow(WId)));
+    connect(KWindowSystem::self(), SIGNAL(windowRemoved(WId)),
+            this, SLOT(removeWindow(WId)));
+    connect(KWindowSystem::self(), SIGNAL(windowChanged(WId,const ulong*)),
+            this, SLOT(windowChanged(WId,const ulong*)));
+    connect(KWindowSystem::self(), SIGNAL(currentDesktopChanged(int)),
+            this, SLOT(updateDesktops()));
+    connect(KWindowSystem::self(), SIGNAL(numberOfDesktopsChanged(int)),
+            this, SLOT(updateDesktops()));
+    connect(KWindowSystem::self(), SIGNAL(desktopNamesChanged()),
+            this, SLOT(updateDesktops()));
+}
+
+WindowTable::~WindowTable()
+{
+}
+
+void WindowTable::load()
+{
+    const QVector<WindowData> windows = readWindows(KWindowSystem::windows());
+
+    QWriteLocker lock(&m_lock);
+    m_snapshot.windows = windows;
+    lock.unlock();
+
+    updateDesktops();
+}
+
+WindowSnapshot WindowTable::snapshot() const
+{
+    QReadLocker lock(&m_lock);
+    return m_snapshot;
+}
+
+bool WindowTable::contains(WId id) const
+{
+    QReadLocker lock(&m_lock);
+    return indexOf(id) != -1;
+}
+
+void WindowTable::addWindow(WId id)
+{
+    const QVector<WindowData> windows = readWindows(QList<WId>() << id);
+    if (windows.isEmpty()) {
+        return;
+    }
+
+    const WindowData &data = windows.first();
+
+    QWriteLocker lock(&m_lock);
+    const int index = indexOf(id);
+    if (index == -1) {
+        m_snapshot.windows << data;
+    } else {
+        m_snapshot.windows[index] = data;
+    }
+    lock.unlock();
+
+    emit windowUpdated(id);
+}
+
+void WindowTable::removeWindow(WId id)
+{
+    QWriteLocker lock(&m_lock);
+    const int index = indexOf(id);
+    if (index == -1) {
+        return;
+    }
+
+    m_snapshot.windows.remove(index);
+    lock.unlock();
+
+    emit windowRemoved(id);
+}
+
+void WindowTable::windowChanged(WId id, const unsigned long *properties)
+{
+    // only properties that end up in the table are worth a round trip
+    if (!(properties[NETWinInfo::PROTOCOLS] & s_properties) &&
+        !(properties[NETWinInfo::PROTOCOLS2] & s_properties2)) {
+        return;
+    }
+
+    addWindow(id);
+}
+
+void WindowTable::updateDesktops()
+{
+    QStringList names;
+    const int count = KWindowSystem::numberOfDesktops();
+    for (int i = 1; i <= count; ++i) {
+        names << KWindowSystem::desktopName(i);
+    }
+
+    const int current = KWindowSystem::currentDesktop();
+
+    QWriteLocker lock(&m_lock);
+    m_snapshot.desktopNames = names;
+    m_snapshot.currentDesktop = current;
+    lock.unlock();
+
+    emit desktopsChanged();
+}
+
+QVector<WindowData> WindowTable::readWindows(const QList<WId> &ids) const
+{
+    if (m_loader) {
+        return m_loader->load(ids, s_windowTypes);
+    }
+
+    QVector<WindowData> windows;
+    foreach (WId id, ids) {
+        WindowData data;
+        if (readWindow(id, data)) {
+            windows << data;
+        }
+    }
+
+    return windows;
+}
+
+bool WindowTable::readWindow(WId id, WindowData &data)
+{
+    KWindowInfo info(id, s_properties, s_properties2);
+    if (!info.valid()) {
+        return false;
+    }
+
+    data.id = id;
+    data.name = info.name();
+    data.className = QString::fromUtf8(info.windowClassName());
+    data.classClass = QString::fromUtf8(info.windowClassClass());
+    data.role = QString::fromUtf8(info.windowRole());
+    data.desktop = info.desktop();
+    data.type = info.windowType(s_windowTypes);
+    data.state = info.state();
+    data.minimized = info.isMinimized();
+
+    const NET::Action actions[] = { NET::ActionMove, NET::ActionResize, NET::ActionMinimize,
+                                    NET::ActionShade, NET::ActionStick, NET::ActionMaxVert,
+                                    NET::ActionMaxHoriz, NET::ActionFullScreen,
+                                    NET::ActionChangeDesktop, NET::ActionClose };
+    data.allowedActions = 0;
+    for (unsigned i = 0; i < sizeof(actions) / sizeof(actions[0]); ++i) {
+        if (info.actionSupported(actions[i])) {
+            data.allowedActions |= actions[i];
+        }
+    }
+
+    return true;
+}
+
+int WindowTable::indexOf(WId id) const
+{
+    for (int i = 0; i < m_snapshot.windows.count(); ++i) {
+        if (m_snapshot.windows[i].id == id) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+#include "moc_windowtable.cpp"
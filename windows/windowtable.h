@@ -0,0 +1,123 @@
+/***************************************************************************
+ *   Copyright 2009 by Martin Gräßlin <kde@martin-graesslin.com>           *
+ *   Copyright 2014 by Aaron Seigo <aseigo@kde.org>                        *
+ *   Copyright 2026 by the Sprinter plugins contributors                   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+#ifndef WINDOWTABLE_H
+#define WINDOWTABLE_H
+
+#include <QList>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QScopedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <NETWM>
+
+class XcbWindowLoader;
+
+/**
+ * What the windows runner knows about a window
+ */
+struct WindowData
+{
+    WindowData();
+
+    bool isOnDesktop(int desktop) const;
+    bool hasState(NET::States s) const;
+    bool actionSupported(NET::Action action) const;
+
+    WId id;
+    QString name;
+    QString className;
+    QString classClass;
+    QString role;
+    int desktop;
+    NET::WindowType type;
+    NET::States state;
+    NET::Actions allowedActions;
+    bool minimized;
+};
+
+/**
+ * The windows and desktops at one point in time
+ */
+struct WindowSnapshot
+{
+    WindowSnapshot();
+
+    int numberOfDesktops() const;
+    QString desktopName(int desktop) const;
+
+    QVector<WindowData> windows;
+    QStringList desktopNames;
+    int currentDesktop;
+};
+
+/**
+ * Keeps track of the windows and desktops. The table is read from the window
+ * system once and from then on kept up to date from the KWindowSystem change
+ * notifications, so reading it never causes any X traffic.
+ *
+ * The table may be read from any thread; snapshots are implicitly shared
+ * copies and are not affected by later updates.
+ */
+class WindowTable : public QObject
+{
+    Q_OBJECT
+
+public:
+    WindowTable(QObject *parent = 0);
+    ~WindowTable();
+
+    /**
+     * Reads all windows and desktops from the window system
+     */
+    void load();
+
+    WindowSnapshot snapshot() const;
+
+    /**
+     * @return true if the window @p id is known and still open
+     */
+    bool contains(WId id) const;
+
+Q_SIGNALS:
+    void windowUpdated(WId id);
+    void windowRemoved(WId id);
+    void desktopsChanged();
+
+private Q_SLOTS:
+    void addWindow(WId id);
+    void removeWindow(WId id);
+    void windowChanged(WId id, const unsigned long *properties);
+    void updateDesktops();
+
+private:
+    QVector<WindowData> readWindows(const QList<WId> &ids) const;
+    static bool readWindow(WId id, WindowData &data);
+    int indexOf(WId id) const;
+
+    QScopedPointer<XcbWindowLoader> m_loader;
+    mutable QReadWriteLock m_lock;
+    WindowSnapshot m_snapshot;
+};
+
+#endif
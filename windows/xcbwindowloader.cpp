@@ -0,0 +1,339 @@
+/***************************************************************************
+ *   Copyright 2026 by the Sprinter plugins contributors                   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "xcbwindowloader.h"
+
+#include <KWindowSystem>
+
+#include <cstdlib>
+#include <cstring>
+
+// in the order of XcbWindowLoader::Atom
+static const char *s_atomNames[] = {
+    "_NET_WM_WINDOW_TYPE",
+    "_NET_WM_WINDOW_TYPE_NORMAL",
+    "_NET_WM_WINDOW_TYPE_DESKTOP",
+    "_NET_WM_WINDOW_TYPE_DOCK",
+    "_NET_WM_WINDOW_TYPE_TOOLBAR",
+    "_NET_WM_WINDOW_TYPE_MENU",
+    "_NET_WM_WINDOW_TYPE_DIALOG",
+    "_NET_WM_WINDOW_TYPE_UTILITY",
+    "_NET_WM_WINDOW_TYPE_SPLASH",
+    "_NET_WM_WINDOW_TYPE_DROPDOWN_MENU",
+    "_NET_WM_WINDOW_TYPE_POPUP_MENU",
+    "_NET_WM_WINDOW_TYPE_TOOLTIP",
+    "_NET_WM_WINDOW_TYPE_NOTIFICATION",
+    "_NET_WM_WINDOW_TYPE_COMBO",
+    "_NET_WM_WINDOW_TYPE_DND",
+    "_KDE_NET_WM_WINDOW_TYPE_OVERRIDE",
+    "_KDE_NET_WM_WINDOW_TYPE_TOPMENU",
+    "_NET_WM_DESKTOP",
+    "_NET_WM_STATE",
+    "_NET_WM_STATE_MODAL",
+    "_NET_WM_STATE_STICKY",
+    "_NET_WM_STATE_MAXIMIZED_VERT",
+    "_NET_WM_STATE_MAXIMIZED_HORZ",
+    "_NET_WM_STATE_SHADED",
+    "_NET_WM_STATE_SKIP_TASKBAR",
+    "_NET_WM_STATE_SKIP_PAGER",
+    "_NET_WM_STATE_HIDDEN",
+    "_NET_WM_STATE_FULLSCREEN",
+    "_NET_WM_STATE_ABOVE",
+    "_NET_WM_STATE_BELOW",
+    "_NET_WM_STATE_DEMANDS_ATTENTION",
+    "WM_STATE",
+    "_NET_WM_NAME",
+    "UTF8_STRING",
+    "WM_WINDOW_ROLE",
+    "_NET_WM_ALLOWED_ACTIONS",
+    "_NET_WM_ACTION_MOVE",
+    "_NET_WM_ACTION_RESIZE",
+    "_NET_WM_ACTION_MINIMIZE",
+    "_NET_WM_ACTION_SHADE",
+    "_NET_WM_ACTION_STICK",
+    "_NET_WM_ACTION_MAXIMIZE_VERT",
+    "_NET_WM_ACTION_MAXIMIZE_HORZ",
+    "_NET_WM_ACTION_FULLSCREEN",
+    "_NET_WM_ACTION_CHANGE_DESKTOP",
+    "_NET_WM_ACTION_CLOSE"
+};
+
+// property lengths are requested in 32 bit units
+static const uint32_t s_maxAtoms = 64;
+static const uint32_t s_maxStringLength = 1024;
+
+static const uint32_t s_iconicState = 3;
+
+static QString stringValue(xcb_get_property_reply_t *reply, bool utf8)
+{
+    if (!reply || reply->type == XCB_ATOM_NONE || reply->format != 8) {
+        return QString();
+    }
+
+    const char *value = static_cast<const char *>(xcb_get_property_value(reply));
+    const int length = xcb_get_property_value_length(reply);
+    return utf8 ? QString::fromUtf8(value, length) : QString::fromLatin1(value, length);
+}
+
+static const xcb_atom_t *atomsValue(xcb_get_property_reply_t *reply, int *count)
+{
+    if (!reply || reply->type != XCB_ATOM_ATOM || reply->format != 32) {
+        *count = 0;
+        return 0;
+    }
+
+    *count = xcb_get_property_value_length(reply) / sizeof(xcb_atom_t);
+    return static_cast<const xcb_atom_t *>(xcb_get_property_value(reply));
+}
+
+static bool cardinalValue(xcb_get_property_reply_t *reply, uint32_t *value)
+{
+    if (!reply || reply->format != 32 || xcb_get_property_value_length(reply) < int(sizeof(uint32_t))) {
+        return false;
+    }
+
+    *value = *static_cast<const uint32_t *>(xcb_get_property_value(reply));
+    return true;
+}
+
+XcbWindowLoader::XcbWindowLoader(xcb_connection_t *connection)
+    : m_connection(connection)
+{
+    xcb_intern_atom_cookie_t cookies[AtomCount];
+    for (int i = 0; i < AtomCount; ++i) {
+        cookies[i] = xcb_intern_atom(m_connection, false, strlen(s_atomNames[i]), s_atomNames[i]);
+    }
+
+    for (int i = 0; i < AtomCount; ++i) {
+        xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(m_connection, cookies[i], 0);
+        m_atoms[i] = reply ? reply->atom : XCB_ATOM_NONE;
+        free(reply);
+    }
+}
+
+QVector<WindowData> XcbWindowLoader::load(const QList<WId> &ids, NET::WindowTypes supportedTypes) const
+{
+    // every request goes out before the first reply is waited for
+    QVector<xcb_get_property_cookie_t> cookies(ids.count() * PropertyCount);
+    for (int i = 0; i < ids.count(); ++i) {
+        const xcb_window_t window = ids[i];
+        xcb_get_property_cookie_t *cookie = cookies.data() + i * PropertyCount;
+        cookie[WindowTypeProperty] = xcb_get_property(m_connection, false, window, m_atoms[NetWmWindowType],
+                                                      XCB_ATOM_ATOM, 0, s_maxAtoms);
+        cookie[DesktopProperty] = xcb_get_property(m_connection, false, window, m_atoms[NetWmDesktop],
+                                                   XCB_ATOM_CARDINAL, 0, 1);
+        cookie[StateProperty] = xcb_get_property(m_connection, false, window, m_atoms[NetWmState],
+                                                 XCB_ATOM_ATOM, 0, s_maxAtoms);
+        cookie[MappingStateProperty] = xcb_get_property(m_connection, false, window, m_atoms[WmState],
+                                                        m_atoms[WmState], 0, 2);
+        cookie[NetNameProperty] = xcb_get_property(m_connection, false, window, m_atoms[NetWmName],
+                                                   m_atoms[Utf8String], 0, s_maxStringLength);
+        cookie[NameProperty] = xcb_get_property(m_connection, false, window, XCB_ATOM_WM_NAME,
+                                                XCB_GET_PROPERTY_TYPE_ANY, 0, s_maxStringLength);
+        cookie[ClassProperty] = xcb_get_property(m_connection, false, window, XCB_ATOM_WM_CLASS,
+                                                 XCB_ATOM_STRING, 0, s_maxStringLength);
+        cookie[RoleProperty] = xcb_get_property(m_connection, false, window, m_atoms[WmWindowRole],
+                                                XCB_ATOM_STRING, 0, s_maxStringLength);
+        cookie[AllowedActionsProperty] = xcb_get_property(m_connection, false, window, m_atoms[NetWmAllowedActions],
+                                                          XCB_ATOM_ATOM, 0, s_maxAtoms);
+    }
+
+    QVector<WindowData> windows;
+    windows.reserve(ids.count());
+    for (int i = 0; i < ids.count(); ++i) {
+        xcb_get_property_reply_t *replies[PropertyCount];
+        bool valid = true;
+        for (int p = 0; p < PropertyCount; ++p) {
+            // errors are collected here rather than left for the event loop;
+            // a window closed in the meantime fails all of its requests
+            xcb_generic_error_t *error = 0;
+            replies[p] = xcb_get_property_reply(m_connection, cookies[i * PropertyCount + p], &error);
+            if (error) {
+                valid = false;
+                free(error);
+            }
+        }
+
+        if (valid) {
+            WindowData data;
+            data.id = ids[i];
+
+            data.type = windowType(replies[WindowTypeProperty], supportedTypes);
+
+            uint32_t desktop;
+            if (cardinalValue(replies[DesktopProperty], &desktop)) {
+                data.desktop = desktop == 0xFFFFFFFF ? int(NET::OnAllDesktops) : int(desktop) + 1;
+            }
+
+            data.state = states(replies[StateProperty]);
+            data.allowedActions = actions(replies[AllowedActionsProperty]);
+
+            data.name = stringValue(replies[NetNameProperty], true);
+            if (data.name.isEmpty()) {
+                xcb_get_property_reply_t *name = replies[NameProperty];
+                data.name = stringValue(name, name && name->type == m_atoms[Utf8String]);
+            }
+
+            // WM_CLASS holds the instance and class names, each null terminated
+            const QString windowClass = stringValue(replies[ClassProperty], false);
+            const int separator = windowClass.indexOf(QChar(0));
+            data.className = windowClass.left(separator);
+            if (separator != -1) {
+                data.classClass = windowClass.mid(separator + 1);
+                const int end = data.classClass.indexOf(QChar(0));
+                if (end != -1) {
+                    data.classClass.truncate(end);
+                }
+            }
+
+            data.role = stringValue(replies[RoleProperty], false);
+
+            // the same rules KWindowInfo::isMinimized() applies
+            uint32_t mappingState;
+            if (cardinalValue(replies[MappingStateProperty], &mappingState) && mappingState == s_iconicState) {
+                if (data.hasState(NET::Hidden) && !data.hasState(NET::Shaded)) {
+                    data.minimized = true;
+                } else {
+                    data.minimized = !KWindowSystem::icccmCompliantMappingState();
+                }
+            }
+
+            windows << data;
+        }
+
+        for (int p = 0; p < PropertyCount; ++p) {
+            free(replies[p]);
+        }
+    }
+
+    return windows;
+}
+
+NET::WindowType XcbWindowLoader::windowType(xcb_get_property_reply_t *reply,
+                                            NET::WindowTypes supportedTypes) const
+{
+    static const struct {
+        Atom atom;
+        NET::WindowType type;
+    } known[] = {
+        { NetWmWindowTypeNormal, NET::Normal },
+        { NetWmWindowTypeDesktop, NET::Desktop },
+        { NetWmWindowTypeDock, NET::Dock },
+        { NetWmWindowTypeToolbar, NET::Toolbar },
+        { NetWmWindowTypeMenu, NET::Menu },
+        { NetWmWindowTypeDialog, NET::Dialog },
+        { NetWmWindowTypeUtility, NET::Utility },
+        { NetWmWindowTypeSplash, NET::Splash },
+        { NetWmWindowTypeDropdownMenu, NET::DropdownMenu },
+        { NetWmWindowTypePopupMenu, NET::PopupMenu },
+        { NetWmWindowTypeTooltip, NET::Tooltip },
+        { NetWmWindowTypeNotification, NET::Notification },
+        { NetWmWindowTypeCombo, NET::ComboBox },
+        { NetWmWindowTypeDnd, NET::DNDIcon },
+        { KdeNetWmWindowTypeOverride, NET::Override },
+        { KdeNetWmWindowTypeTopMenu, NET::TopMenu }
+    };
+
+    // like NETWinInfo::windowType(): the first type in the list that is
+    // both understood and supported wins, the others are fallbacks
+    int count;
+    const xcb_atom_t *atoms = atomsValue(reply, &count);
+    for (int i = 0; i < count; ++i) {
+        for (unsigned t = 0; t < sizeof(known) / sizeof(known[0]); ++t) {
+            if (atoms[i] == m_atoms[known[t].atom] &&
+                NET::typeMatchesMask(known[t].type, supportedTypes)) {
+                return known[t].type;
+            }
+        }
+    }
+
+    return NET::Unknown;
+}
+
+NET::States XcbWindowLoader::states(xcb_get_property_reply_t *reply) const
+{
+    static const struct {
+        Atom atom;
+        NET::State state;
+    } known[] = {
+        { NetWmStateModal, NET::Modal },
+        { NetWmStateSticky, NET::Sticky },
+        { NetWmStateMaximizedVert, NET::MaxVert },
+        { NetWmStateMaximizedHorz, NET::MaxHoriz },
+        { NetWmStateShaded, NET::Shaded },
+        { NetWmStateSkipTaskbar, NET::SkipTaskbar },
+        { NetWmStateSkipPager, NET::SkipPager },
+        { NetWmStateHidden, NET::Hidden },
+        { NetWmStateFullscreen, NET::FullScreen },
+        { NetWmStateAbove, NET::KeepAbove },
+        { NetWmStateBelow, NET::KeepBelow },
+        { NetWmStateDemandsAttention, NET::DemandsAttention }
+    };
+
+    NET::States result = 0;
+    int count;
+    const xcb_atom_t *atoms = atomsValue(reply, &count);
+    for (int i = 0; i < count; ++i) {
+        for (unsigned s = 0; s < sizeof(known) / sizeof(known[0]); ++s) {
+            if (atoms[i] == m_atoms[known[s].atom]) {
+                result |= known[s].state;
+            }
+        }
+    }
+
+    return result;
+}
+
+NET::Actions XcbWindowLoader::actions(xcb_get_property_reply_t *reply) const
+{
+    // as with KWindowInfo::actionSupported(), everything is allowed when
+    // the window manager doesn't tell
+    if (!KWindowSystem::allowedActionsSupported()) {
+        return NET::Actions(~0);
+    }
+
+    static const struct {
+        Atom atom;
+        NET::Action action;
+    } known[] = {
+        { NetWmActionMove, NET::ActionMove },
+        { NetWmActionResize, NET::ActionResize },
+        { NetWmActionMinimize, NET::ActionMinimize },
+        { NetWmActionShade, NET::ActionShade },
+        { NetWmActionStick, NET::ActionStick },
+        { NetWmActionMaximizeVert, NET::ActionMaxVert },
+        { NetWmActionMaximizeHorz, NET::ActionMaxHoriz },
+        { NetWmActionFullscreen, NET::ActionFullScreen },
+        { NetWmActionChangeDesktop, NET::ActionChangeDesktop },
+        { NetWmActionClose, NET::ActionClose }
+    };
+
+    NET::Actions result = 0;
+    int count;
+    const xcb_atom_t *atoms = atomsValue(reply, &count);
+    for (int i = 0; i < count; ++i) {
+        for (unsigned a = 0; a < sizeof(known) / sizeof(known[0]); ++a) {
+            if (atoms[i] == m_atoms[known[a].atom]) {
+                result |= known[a].action;
+            }
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+ *   Copyright 2026 by the Sprinter plugins contributors                   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+#ifndef XCBWINDOWLOADER_H
+#define XCBWINDOWLOADER_H
+
+#include <QList>
+#include <QVector>
+
+#include <xcb/xcb.h>
+
+#include "windowtable.h"
+
+/**
+ * Reads the properties the windows runner needs for many windows at once.
+ *
+ * KWindowInfo reads the properties of one window at a time and waits for
+ * each reply before sending the next request. This loader sends the
+ * requests for all properties of all windows first and only then collects
+ * the replies, so loading any number of windows costs about one round trip
+ * to the X server. The atoms it needs are interned the same way, once, when
+ * the loader is created.
+ */
+class XcbWindowLoader
+{
+public:
+    XcbWindowLoader(xcb_connection_t *connection);
+
+    /**
+     * @param supportedTypes the window types to tell apart, as for
+     * NETWinInfo::windowType(); other types are read as NET::Unknown
+     * @return the windows of @p ids that still exist, in the same order
+     */
+    QVector<WindowData> load(const QList<WId> &ids, NET::WindowTypes supportedTypes) const;
+
+private:
+    enum Atom {
+        NetWmWindowType = 0,
+        NetWmWindowTypeNormal,
+        NetWmWindowTypeDesktop,
+        NetWmWindowTypeDock,
+        NetWmWindowTypeToolbar,
+        NetWmWindowTypeMenu,
+        NetWmWindowTypeDialog,
+        NetWmWindowTypeUtility,
+        NetWmWindowTypeSplash,
+        NetWmWindowTypeDropdownMenu,
+        NetWmWindowTypePopupMenu,
+        NetWmWindowTypeTooltip,
+        NetWmWindowTypeNotification,
+        NetWmWindowTypeCombo,
+        NetWmWindowTypeDnd,
+        KdeNetWmWindowTypeOverride,
+        KdeNetWmWindowTypeTopMenu,
+        NetWmDesktop,
+        NetWmState,
+        NetWmStateModal,
+        NetWmStateSticky,
+        NetWmStateMaximizedVert,
+        NetWmStateMaximizedHorz,
+        NetWmStateShaded,
+        NetWmStateSkipTaskbar,
+        NetWmStateSkipPager,
+        NetWmStateHidden,
+        NetWmStateFullscreen,
+        NetWmStateAbove,
+        NetWmStateBelow,
+        NetWmStateDemandsAttention,
+        WmState,
+        NetWmName,
+        Utf8String,
+        WmWindowRole,
+        NetWmAllowedActions,
+        NetWmActionMove,
+        NetWmActionResize,
+        NetWmActionMinimize,
+        NetWmActionShade,
+        NetWmActionStick,
+        NetWmActionMaximizeVert,
+        NetWmActionMaximizeHorz,
+        NetWmActionFullscreen,
+        NetWmActionChangeDesktop,
+        NetWmActionClose,
+        AtomCount
+    };
+
+    // the properties requested for every window, in request order
+    enum Property {
+        WindowTypeProperty = 0,
+        DesktopProperty,
+        StateProperty,
+        MappingStateProperty,
+        NetNameProperty,
+        NameProperty,
+        ClassProperty,
+        RoleProperty,
+        AllowedActionsProperty,
+        PropertyCount
+    };
+
+    NET::WindowType windowType(xcb_get_property_reply_t *reply, NET::WindowTypes supportedTypes) const;
+    NET::States states(xcb_get_property_reply_t *reply) const;
+    NET::Actions actions(xcb_get_property_reply_t *reply) const;
+
+    xcb_connection_t *m_connection;
+    xcb_atom_t m_atoms[AtomCount];
+};
+
+#endif